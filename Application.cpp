@@ -12,6 +12,8 @@ namespace ClassGame {
         Game *game = nullptr;
         bool gameOver = false;
         int gameWinner = -1;
+        bool monteCarloAI = false;     // start games with the monte carlo AI where there is one
+        bool pondering = false;        // and have the AI think on the human's turn too
 
         //
         // game starting point
@@ -45,6 +47,8 @@ namespace ClassGame {
                     }
                 }
                 if (!game) {
+                    ImGui::Checkbox("Monte Carlo AI", &monteCarloAI);
+                    ImGui::Checkbox("AI thinks on your turn", &pondering);
                     if (ImGui::Button("Start Tic-Tac-Toe")) {
                         game = new TicTacToe();
                         game->setUpBoard();
@@ -80,8 +84,20 @@ namespace ClassGame {
                             game->setUpBoard();
                             ImGui::CloseCurrentPopup();
                         }
+                        if (ImGui::Button("Human vs. Unbeatable AI")) {
+                            Connect4 *connect4 = new Connect4();
+                            connect4->setPerfectPlay(true);
+                            game = connect4;
+                            game->setAIPlayer(1);
+                            game->setUpBoard();
+                            ImGui::CloseCurrentPopup();
+                        }
                         ImGui::EndPopup();
                     }
+                    if (game) {
+                        game->setMonteCarloAI(monteCarloAI);
+                        game->setPondering(pondering);
+                    }
                 }
                 
                 else {
@@ -95,6 +111,20 @@ namespace ClassGame {
                     }
                     if(game){
                         ImGui::Text("Current Player Number: %d", game->getCurrentPlayer()->playerNumber());
+                        if (game->isAIThinking()) {
+                            ImGui::Text("AI is thinking...");
+                        }
+                        else if (game->isPondering()) {
+                            ImGui::Text("AI is thinking on your time...");
+                        }
+                        std::string expected = game->aiExpectedLine();
+                        if (!expected.empty()) {
+                            ImGui::Text("AI expects: %s", expected.c_str());
+                        }
+                        Connect4 *connect4 = dynamic_cast<Connect4 *>(game);
+                        if (connect4 && !gameOver && ImGui::Button("Undo Move")) {
+                            connect4->undoMove();
+                        }
                         ImGui::Text("Current Board State: %s", game->stateString().c_str());
                     }
                 }
@@ -106,6 +136,10 @@ namespace ClassGame {
                     {
                         game->updateAI();
                     }
+                    else if (game->gameHasAI() && !gameOver)
+                    {
+                        game->updatePonder();
+                    }
                     game->drawFrame();
                 }
                 ImGui::End();
@@ -1,14 +1,23 @@
 #include "Checkers.h"
+#include "Logger.h"
 
 Checkers::Checkers() : Game() {
     _grid = new Grid(8, 8);
-    _mustContinueJumping = false;
-    _jumpingPiece = nullptr;
-    _redPieces = 12;
-    _yellowPieces = 12;
+    _monteCarlo = false;
+    _resigned = -1;
+    _monteCarloSearch.setThreads((int)std::thread::hardware_concurrency());
+    refreshMoves();
+    // perfect endgames if the database has been built, searched ones if not
+    if (_endgame.open(CheckersEndgame::DEFAULT_FILE)) {
+        _search.setEndgame(&_endgame);
+    } else {
+        Logger *logger = Logger::GetInstance();
+        logger->Log(std::string("no endgame database at ") + CheckersEndgame::DEFAULT_FILE + ", build it with the checkers_endgame target", logger->WARN, logger->GAME);
+    }
 }
 
 Checkers::~Checkers() {
+    cancelAISearch();
     delete _grid;
 }
 
@@ -19,6 +28,9 @@ void Checkers::setUpBoard() {
 
     // Initialize all squares
     _grid->initializeSquares(80, "boardsquare.png");
+    _position.reset();
+    _resigned = -1;
+    refreshMoves();
 
     // Enable only dark squares and place pieces
     _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
@@ -38,6 +50,10 @@ void Checkers::setUpBoard() {
         }
     });
 
+    if (gameHasAI()) {
+        setAIPlayer(AI_PLAYER);
+    }
+
     startGame();
 }
 
@@ -56,193 +72,97 @@ bool Checkers::actionForEmptyHolder(BitHolder &holder) {
     return false; // Checkers doesn't place new pieces
 }
 
-bool Checkers::canBitMoveFrom(Bit &bit, BitHolder &src) {
-    if (!src.bit() || bit.getOwner() != getCurrentPlayer()) return false;
-    if (_mustContinueJumping && &src != _jumpingPiece) return false;
-
-    ChessSquare* square = static_cast<ChessSquare*>(&src);
-    int x = square->getColumn();
-    int y = square->getRow();
-
-    // Must jump if available
-    if (hasJumpAvailable(bit.getOwner())) {
-        return canJumpFrom(*square);
-    }
-    return true;
+int Checkers::squareOf(BitHolder &holder) const {
+    ChessSquare* square = static_cast<ChessSquare*>(&holder);
+    return CheckersPosition::squareAt(square->getColumn(), square->getRow());
 }
 
-bool Checkers::canBitMoveFromTo(Bit& bit, BitHolder& src, BitHolder& dst) {
-    if (!src.bit() || dst.bit()) return false;
-
-    ChessSquare* srcSquare = static_cast<ChessSquare*>(&src);
-    ChessSquare* dstSquare = static_cast<ChessSquare*>(&dst);
-
-    int srcX = srcSquare->getColumn();
-    int srcY = srcSquare->getRow();
-
-    if (!_grid->isEnabled(dstSquare->getColumn(), dstSquare->getRow())) return false;
-
-    bool isKing = (bit.gameTag() == RED_KING || bit.gameTag() == YELLOW_KING);
-    bool isRed = (bit.getOwner() == getPlayerAt(RED_PLAYER));
+void Checkers::refreshMoves() {
+    _position.generateMoves(_legalMoves);
+    _hops.clear();
+}
 
-    // Simple moves (if no jumps required)
-    if (!_mustContinueJumping && !hasJumpAvailable(bit.getOwner())) {
-        if (isKing) {
-            return dstSquare == _grid->getFL(srcX, srcY) || dstSquare == _grid->getFR(srcX, srcY) ||
-                   dstSquare == _grid->getBL(srcX, srcY) || dstSquare == _grid->getBR(srcX, srcY);
+//
+// the legal move that goes through the hops made so far and then on from {from} to {to},
+// nullptr if there isn't one. a plain move is a single hop, a capture has one per jump
+//
+const CheckersPosition::Move* Checkers::findMove(int from, int to) const {
+    if (!_hops.empty() && _hops.back() != from) return nullptr;
+    int start = _hops.empty() ? from : _hops.front();
+    size_t done = _hops.empty() ? 0 : _hops.size() - 1;
+
+    for (const CheckersPosition::Move &move : _legalMoves) {
+        if (move.from != start) continue;
+        if (move.jumps == 0) {
+            if (done == 0 && move.to == to) return &move;
+            continue;
+        }
+        if (done >= move.jumps || move.path[done] != to) continue;
+        bool samePath = true;
+        for (size_t i = 0; i < done; i++) {
+            if (move.path[i] != _hops[i + 1]) samePath = false;
         }
-        return isRed ? (dstSquare == _grid->getBL(srcX, srcY) || dstSquare == _grid->getBR(srcX, srcY)) :
-                       (dstSquare == _grid->getFL(srcX, srcY) || dstSquare == _grid->getFR(srcX, srcY));
+        if (samePath) return &move;
     }
+    return nullptr;
+}
 
-    // Jump moves
-    if (_mustContinueJumping && &src != _jumpingPiece) return false;
+bool Checkers::canBitMoveFrom(Bit &bit, BitHolder &src) {
+    if (!src.bit() || bit.getOwner() != getCurrentPlayer()) return false;
 
-    // Check all jump directions
-    auto checkJump = [&](ChessSquare* middle, ChessSquare* target) -> bool {
-        if (!middle || !target || !middle->bit()) return false;
-        if (middle->bit()->getOwner() == bit.getOwner()) return false;
-        return dstSquare == target;
-    };
+    // partway through a capture chain only the capturing piece can go on
+    int square = squareOf(src);
+    if (!_hops.empty()) return square == _hops.back();
 
-    if (isKing || !isRed) {
-        if (checkJump(_grid->getFL(srcX, srcY), _grid->getFLFL(srcX, srcY))) return true;
-        if (checkJump(_grid->getFR(srcX, srcY), _grid->getFRFR(srcX, srcY))) return true;
-    }
-    if (isKing || isRed) {
-        if (checkJump(_grid->getBL(srcX, srcY), _grid->getBLBL(srcX, srcY))) return true;
-        if (checkJump(_grid->getBR(srcX, srcY), _grid->getBRBR(srcX, srcY))) return true;
+    for (const CheckersPosition::Move &move : _legalMoves) {
+        if (move.from == square) return true;
     }
-
     return false;
 }
 
-void Checkers::bitMovedFromTo(Bit &bit, BitHolder &src, BitHolder &dst) {
-    ChessSquare* srcSquare = static_cast<ChessSquare*>(&src);
-    ChessSquare* dstSquare = static_cast<ChessSquare*>(&dst);
-
-    int srcX = srcSquare->getColumn();
-    int srcY = srcSquare->getRow();
-    int dstX = dstSquare->getColumn();
-    int dstY = dstSquare->getRow();
-
-    // Check for jump
-    ChessSquare* jumped = nullptr;
-    if (dstSquare == _grid->getFLFL(srcX, srcY)) jumped = _grid->getFL(srcX, srcY);
-    else if (dstSquare == _grid->getFRFR(srcX, srcY)) jumped = _grid->getFR(srcX, srcY);
-    else if (dstSquare == _grid->getBLBL(srcX, srcY)) jumped = _grid->getBL(srcX, srcY);
-    else if (dstSquare == _grid->getBRBR(srcX, srcY)) jumped = _grid->getBR(srcX, srcY);
-
-    if (jumped && jumped->bit()) {
-        // Capture
-        (jumped->bit()->getOwner() == getPlayerAt(RED_PLAYER)) ? _redPieces-- : _yellowPieces--;
-        jumped->destroyBit();
-
-        // Promotion check
-        if ((bit.gameTag() == RED_PIECE && dstY == 7) || (bit.gameTag() == YELLOW_PIECE && dstY == 0)) {
-            bit.setGameTag(bit.gameTag() == RED_PIECE ? RED_KING : YELLOW_KING);
-            bit.setScale(1.3f);
-        }
-
-        // Check for more jumps
-        if (canJumpFrom(*dstSquare)) {
-            _mustContinueJumping = true;
-            _jumpingPiece = &dst;
-            return;
-        }
-    } else {
-        // Regular move - promotion check
-        if ((bit.gameTag() == RED_PIECE && dstY == 7) || (bit.gameTag() == YELLOW_PIECE && dstY == 0)) {
-            bit.setGameTag(bit.gameTag() == RED_PIECE ? RED_KING : YELLOW_KING);
-            bit.setScale(1.3f);
-        }
-    }
+bool Checkers::canBitMoveFromTo(Bit& bit, BitHolder& src, BitHolder& dst) {
+    if (!src.bit() || dst.bit()) return false;
 
-    _mustContinueJumping = false;
-    _jumpingPiece = nullptr;
-    endTurn();
+    int to = squareOf(dst);
+    return to >= 0 && findMove(squareOf(src), to) != nullptr;
 }
 
-bool Checkers::canJumpFrom(ChessSquare& square) const {
-    Bit* piece = square.bit();
-    if (!piece) return false;
-
-    int x = square.getColumn();
-    int y = square.getRow();
-    bool isKing = (piece->gameTag() == RED_KING || piece->gameTag() == YELLOW_KING);
-    bool isRed = (piece->getOwner() == getPlayerAt(RED_PLAYER));
-    Player* player = piece->getOwner();
+void Checkers::bitMovedFromTo(Bit &bit, BitHolder &src, BitHolder &dst) {
+    int from = squareOf(src);
+    int to = squareOf(dst);
+    const CheckersPosition::Move* move = findMove(from, to);
+    if (!move) return;
+
+    if (_hops.empty()) _hops.push_back(from);
+    _hops.push_back(to);
+
+    // take the jumped piece off the board straight away, the position catches up when the move is done
+    if (move->jumps > 0) {
+        ChessSquare* srcSquare = static_cast<ChessSquare*>(&src);
+        ChessSquare* dstSquare = static_cast<ChessSquare*>(&dst);
+        int middleX = (srcSquare->getColumn() + dstSquare->getColumn()) / 2;
+        int middleY = (srcSquare->getRow() + dstSquare->getRow()) / 2;
+        _grid->getSquare(middleX, middleY)->destroyBit();
+    }
 
-    auto checkJumpDir = [&](ChessSquare* middle, ChessSquare* target) -> bool {
-        return middle && middle->bit() && middle->bit()->getOwner() != player &&
-               target && !target->bit();
-    };
+    // a capture has to be followed to the end of its chain
+    size_t hops = move->jumps > 0 ? move->jumps : 1;
+    if (_hops.size() - 1 < hops) return;
 
-    if (isKing || !isRed) {
-        if (checkJumpDir(_grid->getFL(x, y), _grid->getFLFL(x, y))) return true;
-        if (checkJumpDir(_grid->getFR(x, y), _grid->getFRFR(x, y))) return true;
-    }
-    if (isKing || isRed) {
-        if (checkJumpDir(_grid->getBL(x, y), _grid->getBLBL(x, y))) return true;
-        if (checkJumpDir(_grid->getBR(x, y), _grid->getBRBR(x, y))) return true;
+    if (move->promotes) {
+        bit.setGameTag(bit.gameTag() == RED_PIECE ? RED_KING : YELLOW_KING);
+        bit.setScale(1.3f);
     }
-    return false;
-}
-
-bool Checkers::hasJumpAvailable(Player* player) const {
-    bool hasJump = false;
-    _grid->forEachEnabledSquare([&](ChessSquare* square, int x, int y) {
-        if (hasJump) return;
-        Bit* piece = square->bit();
-        if (piece && piece->getOwner() == player) {
-            Checkers* self = const_cast<Checkers*>(this);
-            if (self->canJumpFrom(*square)) {
-                hasJump = true;
-            }
-        }
-    });
-    return hasJump;
+    _position.play(*move);
+    refreshMoves();
+    endTurn();
 }
 
+// the side to move loses when it has no legal move, which includes having no pieces left
 Player* Checkers::checkForWinner() {
-    if (_redPieces == 0) return getPlayerAt(YELLOW_PLAYER);
-    if (_yellowPieces == 0) return getPlayerAt(RED_PLAYER);
-
-    // Check if current player has any moves
-    Player* current = getCurrentPlayer();
-    bool hasMove = false;
-
-    _grid->forEachEnabledSquare([&](ChessSquare* square, int x, int y) {
-        if (hasMove) return;
-        Bit* piece = square->bit();
-        if (piece && piece->getOwner() == current) {
-            bool isKing = (piece->gameTag() == RED_KING || piece->gameTag() == YELLOW_KING);
-            bool isRed = (current == getPlayerAt(RED_PLAYER));
-
-            // Check for any valid move
-            auto checkMove = [&](ChessSquare* target) {
-                if (target && !target->bit()) hasMove = true;
-            };
-
-            if (isKing) {
-                checkMove(_grid->getFL(x, y));
-                checkMove(_grid->getFR(x, y));
-                checkMove(_grid->getBL(x, y));
-                checkMove(_grid->getBR(x, y));
-            } else if (isRed) {
-                checkMove(_grid->getBL(x, y));
-                checkMove(_grid->getBR(x, y));
-            } else {
-                checkMove(_grid->getFL(x, y));
-                checkMove(_grid->getFR(x, y));
-            }
-        }
-    });
-
-    if (!hasMove) {
-        return current == getPlayerAt(RED_PLAYER) ? getPlayerAt(YELLOW_PLAYER) : getPlayerAt(RED_PLAYER);
-    }
-    return nullptr;
+    if (_resigned >= 0) return getPlayerAt(_resigned == RED_PLAYER ? YELLOW_PLAYER : RED_PLAYER);
+    if (!_legalMoves.empty()) return nullptr;
+    return getCurrentPlayer() == getPlayerAt(RED_PLAYER) ? getPlayerAt(YELLOW_PLAYER) : getPlayerAt(RED_PLAYER);
 }
 
 bool Checkers::checkForDraw() {
@@ -250,13 +170,13 @@ bool Checkers::checkForDraw() {
 }
 
 void Checkers::stopGame() {
+    cancelAISearch();
     _grid->forEachSquare([](ChessSquare* square, int x, int y) {
         square->destroyBit();
     });
-    _mustContinueJumping = false;
-    _jumpingPiece = nullptr;
-    _redPieces = 12;
-    _yellowPieces = 12;
+    _position.reset();
+    _resigned = -1;
+    refreshMoves();
 }
 
 std::string Checkers::initialStateString() {
@@ -264,31 +184,92 @@ std::string Checkers::initialStateString() {
 }
 
 std::string Checkers::stateString() {
-    return _grid->getStateString();
+    return _position.state();
 }
 
 void Checkers::setStateString(const std::string &s) {
-    if (s.length() != 32) return;
-
-    _redPieces = 0;
-    _yellowPieces = 0;
+    if (!_position.setState(s, getCurrentTurnNo() & 1)) return;
+    _resigned = -1;
+    refreshMoves();
 
     _grid->setStateString(s);
 
     // Recreate pieces from state
-    size_t index = 0;
+    int index = 0;
     _grid->forEachEnabledSquare([&](ChessSquare* square, int x, int y) {
-        if (index < s.length()) {
-            int pieceType = s[index++] - '0';
-            if (pieceType != 0) {
-                Bit* piece = createPiece(pieceType);
-                piece->setPosition(square->getPosition());
-                square->setBit(piece);
-                (pieceType == RED_PIECE || pieceType == RED_KING) ? _redPieces++ : _yellowPieces++;
-            }
+        int pieceType = _position.piece(index++);
+        if (pieceType != EMPTY) {
+            Bit* piece = createPiece(pieceType);
+            piece->setPosition(square->getPosition());
+            square->setBit(piece);
         }
     });
 }
 
-void Checkers::updateAI() {}
+// the piece on {square} is replaced with whatever the position has there
+void Checkers::syncSquare(int square) {
+    ChessSquare* holder = _grid->getSquare(CheckersPosition::squareX(square), CheckersPosition::squareY(square));
+    holder->destroyBit();
+    int pieceType = _position.piece(square);
+    if (pieceType != EMPTY) {
+        Bit* piece = createPiece(pieceType);
+        piece->setPosition(holder->getPosition());
+        holder->setBit(piece);
+    }
+}
+
+std::future<int> Checkers::startAISearch() {
+    if (!gameHasAI() || checkForWinner() || checkForDraw()) return std::future<int>();
+
+    CheckersPosition position = _position;
+    return std::async(std::launch::async, [this, position]() {
+        if (_monteCarlo) {
+            return monteCarloMove(position);
+        }
+        return _search.findBestMove(position, &_aiCancel);
+    });
+}
+
+// the monte carlo search's move as an index into the moves generated for {position}, -1 if there are none
+int Checkers::monteCarloMove(const CheckersPosition &position) {
+    CheckersPosition::Move best;
+    if (!_monteCarloSearch.findBestMove(CheckersSearchPosition(position), best, &_aiCancel)) return -1;
+
+    std::vector<CheckersPosition::Move> moves;
+    position.generateMoves(moves);
+    for (size_t i = 0; i < moves.size(); i++) {
+        if (moves[i].from == best.from && moves[i].to == best.to && moves[i].captured == best.captured) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+// a move is its index in _legalMoves, which the search generated the same way from the same position
+void Checkers::applyAIMove(int move) {
+    Logger *logger = Logger::GetInstance();
+    if (_monteCarlo) {
+        logger->Log("AI ran " + std::to_string(_monteCarloSearch.getPlayouts()) + " playouts (" + std::to_string((int)_monteCarloSearch.getPlayoutsPerSecond()) + " a second)", logger->INFO, logger->GAME);
+    } else {
+        logger->Log("AI searched " + std::to_string(_search.getNodesSearched()) + " nodes to depth " + std::to_string(_search.getCompletedDepth()), logger->INFO, logger->GAME);
+    }
+
+    if (move < 0 || move >= (int)_legalMoves.size()) {
+        // no move to play, the side to move resigns rather than have the search start over every frame
+        logger->Log("AI turn failed: no move found, resigning", logger->ERROR, logger->GAME);
+        _resigned = getCurrentPlayer()->playerNumber();
+        endTurn();
+        return;
+    }
+
+    CheckersPosition::Move played = _legalMoves[move];
+    _position.play(played);
+    syncSquare(played.from);
+    syncSquare(played.to);
+    for (uint32_t captured = played.captured; captured; captured &= captured - 1) {
+        syncSquare(std::countr_zero(captured));
+    }
+    refreshMoves();
+    endTurn();
+}
 
@@ -1,5 +1,10 @@
 #pragma once
 #include "Game.h"
+#include "CheckersPosition.h"
+#include "CheckersSearch.h"
+#include "MonteCarloSearch.h"
+#include "SearchPositions.h"
+#include <vector>
 
 // NOTE: If Square class needs modifications to support colored squares for checkerboard pattern,
 // add a method like setColor(ImVec4 color) to Square class
@@ -24,10 +29,16 @@ public:
     void        bitMovedFromTo(Bit &bit, BitHolder &src, BitHolder &dst) override;
 
     // AI methods
-    void        updateAI() override;
-    bool        gameHasAI() override { return false; } // Set to true when AI is implemented
+    std::future<int> startAISearch() override;
+    void        applyAIMove(int move) override;
+    bool        gameHasAI() override { return true; }
+    void        setMonteCarloAI(bool monteCarlo) override { _monteCarlo = monteCarlo; }
     Grid* getGrid() override { return _grid; }
 
+    // AI tuning and stats
+    void        setSearchTimeBudget(int milliseconds) { _search.setTimeBudget(milliseconds); }
+    uint64_t    getNodesSearched() const { return _search.getNodesSearched(); }
+
 private:
     // Constants for piece types
     static const int EMPTY = 0;
@@ -42,23 +53,26 @@ private:
 
     // Helper methods
     Bit*        createPiece(int pieceType);
-    int         getPieceType(const Bit& bit) const;
-    bool        isKing(const Bit& bit) const;
-    bool        isValidMove(int srcX, int srcY, int dstX, int dstY, Player* player) const;
-    bool        isJumpMove(int srcX, int srcY, int dstX, int dstY) const;
-    bool        hasJumpAvailable(Player* player) const;
-    bool        canJumpFrom(ChessSquare& square) const;
-    void        performJump(int srcX, int srcY, int dstX, int dstY);
-    void        promoteToKing(Bit& bit, int y);
     void        getBoardPosition(BitHolder &holder, int &x, int &y) const;
-    bool        isValidSquare(int x, int y) const;
+    int         squareOf(BitHolder &holder) const;
+    const CheckersPosition::Move* findMove(int from, int to) const;
+    void        refreshMoves();
+    void        syncSquare(int square);
+    int         monteCarloMove(const CheckersPosition &position);
 
-    // Board representation
+    // Board representation, the position is the real state at the start of the turn and
+    // the grid just shows it, along with the hops of a capture chain that's under way
     Grid*        _grid;
+    CheckersPosition _position;
+
+    // AI search engine, searches its own copy of the position on a worker thread
+    CheckersEndgame _endgame;       // declared first so it outlives the search that uses it
+    CheckersSearch _search;
+    MonteCarloSearch<CheckersSearchPosition> _monteCarloSearch;
+    bool         _monteCarlo;       // search with _monteCarloSearch instead of _search
 
     // Game state
-    bool        _mustContinueJumping;
-    BitHolder*  _jumpingPiece;
-    int         _redPieces;
-    int         _yellowPieces;
+    std::vector<CheckersPosition::Move> _legalMoves;   // for the side to move, generated once a turn
+    std::vector<int> _hops;     // squares the moving piece has visited this turn, starting with where it was
+    int          _resigned;     // the player who resigned, -1 while the game is still on
 };
\ No newline at end of file
@@ -0,0 +1,412 @@
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include "CheckersEndgame.h"
+
+static const uint32_t TOP_ROW = 0x0000000fu;
+static const uint32_t BOTTOM_ROW = 0xf0000000u;
+
+// values in a compressed block
+static const int PACKED_CODES = 81;     // 4 values in base 3
+static const int MIN_RUN = 5;
+static const int MAX_RUN = 62;          // 81 + 3 * 58 codes fill the byte
+
+// binomial coefficients for the combination ranks
+struct Binomials
+{
+    uint64_t c[33][33];
+
+    Binomials()
+    {
+        for (int n = 0; n <= 32; n++) {
+            c[n][0] = 1;
+            for (int k = 1; k <= 32; k++) {
+                c[n][k] = (n == 0) ? 0 : c[n - 1][k - 1] + c[n - 1][k];
+            }
+        }
+    }
+};
+
+static const Binomials BINOMIALS;
+
+static uint64_t choose(int n, int k)
+{
+    return (n < 0 || k < 0 || k > n) ? 0 : BINOMIALS.c[n][k];
+}
+
+// colex rank of a set of bits: the i-th lowest bit, at position s, adds C(s, i)
+static uint64_t rank(uint32_t bits)
+{
+    uint64_t result = 0;
+    for (int i = 1; bits; bits &= bits - 1, i++) {
+        result += choose(std::countr_zero(bits), i);
+    }
+    return result;
+}
+
+static uint32_t unrank(uint64_t rank, int count)
+{
+    uint32_t bits = 0;
+    for (int i = count; i > 0; i--) {
+        int s = i - 1;
+        while (s < 31 && choose(s + 1, i) <= rank) s++;
+        bits |= 1u << s;
+        rank -= choose(s, i);
+    }
+    return bits;
+}
+
+// {bits} as positions among the set bits of {free}, and back
+static uint32_t compress(uint32_t bits, uint32_t free)
+{
+    uint32_t result = 0;
+    for (; bits; bits &= bits - 1) {
+        int s = std::countr_zero(bits);
+        result |= 1u << std::popcount(free & ((1u << s) - 1));
+    }
+    return result;
+}
+
+static uint32_t expand(uint32_t bits, uint32_t free)
+{
+    uint32_t result = 0;
+    int position = 0;
+    for (; free; free &= free - 1, position++) {
+        if (bits & (1u << position)) result |= free & (0u - free);
+    }
+    return result;
+}
+
+CheckersEndgame::CheckersEndgame()
+{
+    _header = nullptr;
+    _slices = nullptr;
+    _offsets = nullptr;
+    _data = nullptr;
+    _maxPieces = 0;
+    _newest = -1;
+    _oldest = -1;
+    _probes = 0;
+    _blocksDecoded = 0;
+}
+
+CheckersEndgame::~CheckersEndgame()
+{
+    close();
+}
+
+bool CheckersEndgame::open(const std::string &path)
+{
+    close();
+    if (!_file.open(path)) {
+        return false;
+    }
+
+    // validate the header and that the file is as long as its tables say
+    const Header *header = reinterpret_cast<const Header *>(_file.data());
+    size_t tablesEnd = sizeof(Header);
+    if (_file.size() >= sizeof(Header)) {
+        tablesEnd += (size_t)header->sliceCount * sizeof(SliceEntry) + ((size_t)header->blockCount + 1) * sizeof(uint64_t);
+    }
+    if (_file.size() < sizeof(Header) || std::memcmp(header->magic, "CKDB", 4) != 0 || header->version != VERSION ||
+        header->blockSize != BLOCK_SIZE || header->maxPieces > MAX_PIECES || _file.size() < tablesEnd) {
+        close();
+        return false;
+    }
+
+    const uint8_t *base = _file.data();
+    const SliceEntry *slices = reinterpret_cast<const SliceEntry *>(base + sizeof(Header));
+    const uint64_t *offsets = reinterpret_cast<const uint64_t *>(slices + header->sliceCount);
+    if (tablesEnd + offsets[header->blockCount] > _file.size()) {
+        close();
+        return false;
+    }
+
+    int size = (int)header->maxPieces + 1;
+    _sliceLookup.assign((size_t)size * size * size * size, -1);
+    for (uint32_t i = 0; i < header->sliceCount; i++) {
+        const SliceEntry &slice = slices[i];
+        if (slice.redMen + slice.redKings + slice.yellowMen + slice.yellowKings > (int)header->maxPieces) {
+            close();
+            return false;
+        }
+        int at = ((slice.redMen * size + slice.redKings) * size + slice.yellowMen) * size + slice.yellowKings;
+        _sliceLookup[at] = (int)i;
+    }
+
+    _header = header;
+    _slices = slices;
+    _offsets = offsets;
+    _data = base + tablesEnd;
+    _maxPieces = (int)header->maxPieces;
+    _cache.reserve(CACHE_BLOCKS);
+    return true;
+}
+
+void CheckersEndgame::close()
+{
+    std::lock_guard<std::mutex> lock(_cacheLock);
+    _file.close();
+    _header = nullptr;
+    _slices = nullptr;
+    _offsets = nullptr;
+    _data = nullptr;
+    _maxPieces = 0;
+    _sliceLookup.clear();
+    _cache.clear();
+    _cached.clear();
+    _newest = -1;
+    _oldest = -1;
+}
+
+//
+// indexing
+//
+
+uint64_t CheckersEndgame::sliceSize(int redMen, int redKings, int yellowMen, int yellowKings)
+{
+    int free = 32 - redMen - yellowMen;
+    return choose(28, redMen) * choose(28, yellowMen) * choose(free, redKings) * choose(free - redKings, yellowKings);
+}
+
+bool CheckersEndgame::index(uint32_t red, uint32_t yellow, uint32_t kings, uint64_t &index)
+{
+    uint32_t redMen = red & ~kings;
+    uint32_t yellowMen = yellow & ~kings;
+    if ((redMen & BOTTOM_ROW) || (yellowMen & TOP_ROW)) {
+        return false;
+    }
+
+    int free = 32 - std::popcount(redMen) - std::popcount(yellowMen);
+    int redKingCount = std::popcount(red & kings);
+    uint32_t freeSquares = ~(redMen | yellowMen);
+
+    index = rank(redMen) * choose(28, std::popcount(yellowMen)) + rank(yellowMen >> 4);
+    index = index * choose(free, redKingCount) + rank(compress(red & kings, freeSquares));
+    index = index * choose(free - redKingCount, std::popcount(yellow & kings)) +
+            rank(compress(yellow & kings, freeSquares & ~(red & kings)));
+    return true;
+}
+
+bool CheckersEndgame::unindex(int redMen, int redKings, int yellowMen, int yellowKings, uint64_t index,
+                              uint32_t &red, uint32_t &yellow, uint32_t &kings)
+{
+    int free = 32 - redMen - yellowMen;
+    uint64_t yellowKingCount = choose(free - redKings, yellowKings);
+    uint64_t yellowKingRank = index % yellowKingCount;
+    index /= yellowKingCount;
+    uint64_t redKingCount = choose(free, redKings);
+    uint64_t redKingRank = index % redKingCount;
+    index /= redKingCount;
+    uint64_t yellowMenCount = choose(28, yellowMen);
+
+    uint32_t redMenSquares = unrank(index / yellowMenCount, redMen);
+    uint32_t yellowMenSquares = unrank(index % yellowMenCount, yellowMen) << 4;
+    if (redMenSquares & yellowMenSquares) {
+        return false;
+    }
+
+    uint32_t freeSquares = ~(redMenSquares | yellowMenSquares);
+    uint32_t redKingSquares = expand(unrank(redKingRank, redKings), freeSquares);
+    uint32_t yellowKingSquares = expand(unrank(yellowKingRank, yellowKings), freeSquares & ~redKingSquares);
+
+    red = redMenSquares | redKingSquares;
+    yellow = yellowMenSquares | yellowKingSquares;
+    kings = redKingSquares | yellowKingSquares;
+    return true;
+}
+
+// reversing the bits turns the board round
+uint32_t CheckersEndgame::flip(uint32_t board)
+{
+    board = ((board >> 1) & 0x55555555u) | ((board & 0x55555555u) << 1);
+    board = ((board >> 2) & 0x33333333u) | ((board & 0x33333333u) << 2);
+    board = ((board >> 4) & 0x0f0f0f0fu) | ((board & 0x0f0f0f0fu) << 4);
+    board = ((board >> 8) & 0x00ff00ffu) | ((board & 0x00ff00ffu) << 8);
+    return (board >> 16) | (board << 16);
+}
+
+//
+// lookup
+//
+
+int CheckersEndgame::sliceIndex(int redMen, int redKings, int yellowMen, int yellowKings) const
+{
+    int size = _maxPieces + 1;
+    return _sliceLookup[((redMen * size + redKings) * size + yellowMen) * size + yellowKings];
+}
+
+int CheckersEndgame::probe(const CheckersPosition &position) const
+{
+    if (!isOpen()) {
+        return UNKNOWN;
+    }
+
+    // always look at it with red to move
+    uint32_t red = position.pieces(CheckersPosition::RED);
+    uint32_t yellow = position.pieces(CheckersPosition::YELLOW);
+    uint32_t kings = position.kings();
+    if (position.playerToMove() == CheckersPosition::YELLOW) {
+        uint32_t turned = flip(red);
+        red = flip(yellow);
+        yellow = turned;
+        kings = flip(kings);
+    }
+
+    int redKings = std::popcount(red & kings);
+    int redMen = std::popcount(red) - redKings;
+    int yellowKings = std::popcount(yellow & kings);
+    int yellowMen = std::popcount(yellow) - yellowKings;
+    if (redMen + redKings + yellowMen + yellowKings > _maxPieces) {
+        return UNKNOWN;
+    }
+    if (!red) return LOSS;
+    if (!yellow) return WIN;
+
+    int slice = sliceIndex(redMen, redKings, yellowMen, yellowKings);
+    uint64_t at;
+    if (slice < 0 || !index(red, yellow, kings, at)) {
+        return UNKNOWN;
+    }
+    return blockValue(_slices[slice].firstBlock + (uint32_t)(at / BLOCK_SIZE), (int)(at % BLOCK_SIZE));
+}
+
+int CheckersEndgame::blockValue(uint32_t block, int offset) const
+{
+    std::lock_guard<std::mutex> lock(_cacheLock);
+    _probes++;
+
+    int slot;
+    auto found = _cached.find(block);
+    if (found != _cached.end()) {
+        slot = found->second;
+        if (slot == _newest) {
+            return _cache[slot].values[offset];
+        }
+        // take it out of the list, it goes back in at the front
+        CacheEntry &entry = _cache[slot];
+        _cache[entry.newer].older = entry.older;
+        if (entry.older >= 0) _cache[entry.older].newer = entry.newer;
+        else _oldest = entry.newer;
+    } else if ((int)_cache.size() < CACHE_BLOCKS) {
+        slot = (int)_cache.size();
+        _cache.emplace_back();
+        decode(block, _cache[slot].values);
+    } else {
+        // reuse the least recently used block
+        slot = _oldest;
+        _oldest = _cache[slot].newer;
+        _cache[_oldest].older = -1;
+        _cached.erase(_cache[slot].block);
+        decode(block, _cache[slot].values);
+    }
+
+    CacheEntry &entry = _cache[slot];
+    if (found == _cached.end()) {
+        entry.block = block;
+        _cached[block] = slot;
+        _blocksDecoded++;
+    }
+    entry.newer = -1;
+    entry.older = _newest;
+    if (_newest >= 0) _cache[_newest].newer = slot;
+    _newest = slot;
+    if (_oldest < 0) _oldest = slot;
+    return entry.values[offset];
+}
+
+void CheckersEndgame::decode(uint32_t block, uint8_t *values) const
+{
+    const uint8_t *code = _data + _offsets[block];
+    const uint8_t *end = _data + _offsets[block + 1];
+    int count = 0;
+    for (; code < end && count < BLOCK_SIZE; code++) {
+        int byte = *code;
+        if (byte < PACKED_CODES) {
+            for (int i = 0; i < 4 && count < BLOCK_SIZE; i++, byte /= 3) {
+                values[count++] = (uint8_t)(byte % 3);
+            }
+        } else {
+            byte -= PACKED_CODES;
+            int value = byte / (MAX_RUN - MIN_RUN + 1);
+            int run = byte % (MAX_RUN - MIN_RUN + 1) + MIN_RUN;
+            for (int i = 0; i < run && count < BLOCK_SIZE; i++) {
+                values[count++] = (uint8_t)value;
+            }
+        }
+    }
+}
+
+//
+// writing
+//
+
+bool CheckersEndgame::write(const std::string &path, int maxPieces, const std::vector<Table> &tables)
+{
+    if (maxPieces > MAX_PIECES) {
+        return false;
+    }
+
+    std::vector<SliceEntry> slices;
+    std::vector<uint64_t> offsets;
+    std::vector<uint8_t> data;
+    for (const Table &table : tables) {
+        uint64_t positions = sliceSize(table.redMen, table.redKings, table.yellowMen, table.yellowKings);
+        if (table.packed.size() < (positions + 3) / 4) {
+            return false;
+        }
+
+        SliceEntry slice;
+        slice.redMen = (uint8_t)table.redMen;
+        slice.redKings = (uint8_t)table.redKings;
+        slice.yellowMen = (uint8_t)table.yellowMen;
+        slice.yellowKings = (uint8_t)table.yellowKings;
+        slice.firstBlock = (uint32_t)offsets.size();
+        slice.positions = positions;
+        slices.push_back(slice);
+
+        for (uint64_t start = 0; start < positions; start += BLOCK_SIZE) {
+            offsets.push_back(data.size());
+            uint64_t count = std::min<uint64_t>(BLOCK_SIZE, positions - start);
+            uint64_t i = 0;
+            while (i < count) {
+                int value = packedValue(table.packed, start + i);
+                uint64_t run = 1;
+                while (i + run < count && run < MAX_RUN && packedValue(table.packed, start + i + run) == value) {
+                    run++;
+                }
+                if (run >= MIN_RUN) {
+                    data.push_back((uint8_t)(PACKED_CODES + value * (MAX_RUN - MIN_RUN + 1) + (run - MIN_RUN)));
+                    i += run;
+                    continue;
+                }
+                int packed = 0;
+                for (int k = 3; k >= 0; k--) {
+                    packed = packed * 3 + ((i + k < count) ? packedValue(table.packed, start + i + k) : 0);
+                }
+                data.push_back((uint8_t)packed);
+                i += 4;
+            }
+        }
+    }
+    offsets.push_back(data.size());
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+
+    Header header;
+    std::memcpy(header.magic, "CKDB", 4);
+    header.version = VERSION;
+    header.maxPieces = (uint32_t)maxPieces;
+    header.sliceCount = (uint32_t)slices.size();
+    header.blockSize = BLOCK_SIZE;
+    header.blockCount = (uint32_t)offsets.size() - 1;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(slices.data()), slices.size() * sizeof(SliceEntry));
+    file.write(reinterpret_cast<const char *>(offsets.data()), offsets.size() * sizeof(uint64_t));
+    file.write(reinterpret_cast<const char *>(data.data()), data.size());
+    return (bool)file;
+}
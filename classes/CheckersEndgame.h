@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "CheckersPosition.h"
+#include "MappedFile.h"
+
+//
+// checkers endgame database: win, loss or draw for every position with few enough pieces
+//
+// positions are grouped into slices by how many men and kings each side has, and only
+// positions with red to move are stored: yellow to move is the same position turned round
+// (square s becomes 31 - s) with the colors swapped. within a slice a position's index is
+// the combination rank of the red men on squares 0-27, the yellow men on 4-31, then the red
+// and yellow kings on whatever squares the men left free. red and yellow men on the same
+// square make an index no position has, which is never looked up.
+//
+// the database is built offline by tools/checkers_egdb.cpp and lives in one file:
+//   header     magic "CKDB", version, max pieces, slice count, block size, block count (6 x uint32)
+//   slices     red men, red kings, yellow men, yellow kings (4 x uint8), first block (uint32)
+//              and position count (uint64) for each slice
+//   offsets    where each block starts in the data, plus where the last one ends (uint64)
+//   data       the blocks
+// every slice is cut into blocks of BLOCK_SIZE values, each compressed on its own: a byte
+// below 81 is the next 4 values in base 3, a byte from 81 up is a run of 5 to 62 copies of
+// one value. the file is memory mapped and blocks are only decompressed when a probe needs
+// them, into a small cache that throws out the least recently used block
+//
+class CheckersEndgame
+{
+public:
+    // for the side to move, the order matches the 2 bits a value takes while building
+    enum Value
+    {
+        DRAW = 0,
+        WIN = 1,
+        LOSS = 2,
+        UNKNOWN = 3     // not in the database
+    };
+
+    // one slice's values with red to move, 4 to a byte, lowest bits first
+    struct Table
+    {
+        int         redMen, redKings, yellowMen, yellowKings;
+        std::vector<uint8_t> packed;
+    };
+
+    CheckersEndgame();
+    ~CheckersEndgame();
+    CheckersEndgame(const CheckersEndgame &) = delete;
+    CheckersEndgame &operator=(const CheckersEndgame &) = delete;
+
+    // map a database file, returns false (and stays closed) if it's missing or malformed
+    bool        open(const std::string &path);
+    void        close();
+    bool        isOpen() const { return _slices != nullptr; }
+    int         maxPieces() const { return _maxPieces; }
+
+    // the value of {position} for the side to move, UNKNOWN if it has too many pieces.
+    // safe to call from any number of threads, they share the block cache
+    int         probe(const CheckersPosition &position) const;
+
+    // statistics
+    uint64_t    getProbes() const { return _probes; }
+    uint64_t    getBlocksDecoded() const { return _blocksDecoded; }
+
+    // compress {tables} into a database file
+    static bool write(const std::string &path, int maxPieces, const std::vector<Table> &tables);
+
+    // indexing, shared with the generator
+    static uint64_t sliceSize(int redMen, int redKings, int yellowMen, int yellowKings);
+    // the index of a position with red to move in its slice, false if a man is on its own crowning row
+    static bool     index(uint32_t red, uint32_t yellow, uint32_t kings, uint64_t &index);
+    // the position at {index} in a slice, false if no position has that index
+    static bool     unindex(int redMen, int redKings, int yellowMen, int yellowKings, uint64_t index,
+                            uint32_t &red, uint32_t &yellow, uint32_t &kings);
+    // the board turned round, square s goes to 31 - s
+    static uint32_t flip(uint32_t board);
+
+    static int      packedValue(const std::vector<uint8_t> &packed, uint64_t index)
+    {
+        return (packed[index >> 2] >> ((index & 3) * 2)) & 3;
+    }
+
+    static const int BLOCK_SIZE = 8192;
+    static const int CACHE_BLOCKS = 256;    // 2MB of decompressed values
+    static const int MAX_PIECES = 8;        // the file format's limit, far past what can be built
+    static constexpr const char *DEFAULT_FILE = "resources/checkers_endgame.bin";
+
+private:
+    struct Header
+    {
+        char     magic[4];
+        uint32_t version;
+        uint32_t maxPieces;
+        uint32_t sliceCount;
+        uint32_t blockSize;
+        uint32_t blockCount;
+    };
+
+    struct SliceEntry
+    {
+        uint8_t  redMen, redKings, yellowMen, yellowKings;
+        uint32_t firstBlock;
+        uint64_t positions;
+    };
+
+    // one decompressed block, linked into the least recently used list
+    struct CacheEntry
+    {
+        uint32_t block;
+        int      newer, older;
+        uint8_t  values[BLOCK_SIZE];
+    };
+
+    static const uint32_t VERSION = 1;
+
+    int         sliceIndex(int redMen, int redKings, int yellowMen, int yellowKings) const;
+    int         blockValue(uint32_t block, int offset) const;
+    void        decode(uint32_t block, uint8_t *values) const;
+
+    MappedFile  _file;
+    const Header *_header;
+    const SliceEntry *_slices;
+    const uint64_t *_offsets;
+    const uint8_t *_data;
+    int         _maxPieces;
+    std::vector<int> _sliceLookup;  // slice by piece counts, -1 where there isn't one
+
+    // the block cache, _newest and _oldest are the ends of the list
+    mutable std::mutex _cacheLock;
+    mutable std::vector<CacheEntry> _cache;
+    mutable std::unordered_map<uint32_t, int> _cached;
+    mutable int _newest;
+    mutable int _oldest;
+    mutable uint64_t _probes;
+    mutable uint64_t _blocksDecoded;
+};
@@ -0,0 +1,256 @@
+#include "CheckersPosition.h"
+
+//
+// square masks. rows 0, 2, 4, 6 start on a light square, so their first dark square is
+// x = 1 and their last is on the right edge. rows 1, 3, 5, 7 start on the left edge
+//
+static const uint32_t EVEN_ROWS = 0x0f0f0f0fu;
+static const uint32_t ODD_ROWS = 0xf0f0f0f0u;
+static const uint32_t FIRST_IN_ROW = 0x11111111u;
+static const uint32_t LAST_IN_ROW = 0x88888888u;
+static const uint32_t TOP_ROW = 0x0000000fu;
+static const uint32_t BOTTOM_ROW = 0xf0000000u;
+
+// direction 0 is up-left, 1 up-right, 2 down-left, 3 down-right (FL, FR, BL, BR on the grid)
+// and 3 - d is the way back. squares stepping off the side are masked off before the shift,
+// off the top or bottom fall out of the 32 bits by themselves
+static inline uint32_t step(uint32_t squares, int direction)
+{
+    switch (direction) {
+        case 0:  return ((squares & EVEN_ROWS) >> 4) | ((squares & ODD_ROWS & ~FIRST_IN_ROW) >> 5);
+        case 1:  return ((squares & EVEN_ROWS & ~LAST_IN_ROW) >> 3) | ((squares & ODD_ROWS) >> 4);
+        case 2:  return ((squares & EVEN_ROWS) << 4) | ((squares & ODD_ROWS & ~FIRST_IN_ROW) << 3);
+        default: return ((squares & EVEN_ROWS & ~LAST_IN_ROW) << 5) | ((squares & ODD_ROWS) << 4);
+    }
+}
+
+// red men move down the board, yellow men up, kings both ways
+static inline bool isForward(int player, int direction)
+{
+    return (player == CheckersPosition::RED) == (direction >= 2);
+}
+
+static inline uint32_t promotionRow(int player)
+{
+    return (player == CheckersPosition::RED) ? BOTTOM_ROW : TOP_ROW;
+}
+
+CheckersPosition::CheckersPosition()
+{
+    reset();
+}
+
+void CheckersPosition::reset()
+{
+    _pieces[RED] = 0x00000fffu;
+    _pieces[YELLOW] = 0xfff00000u;
+    _kings = 0;
+    _playerToMove = RED;
+}
+
+bool CheckersPosition::setState(const std::string &state, int playerToMove)
+{
+    if (state.length() != SQUARES) return false;
+
+    // anything that isn't a piece (like the '-' in the initial state string) is an empty square
+    uint32_t pieces[2] = {0, 0};
+    uint32_t kings = 0;
+    for (int s = 0; s < SQUARES; s++) {
+        int piece = state[s] - '0';
+        if (owner(piece) >= 0) pieces[owner(piece)] |= 1u << s;
+        if (isKing(piece)) kings |= 1u << s;
+    }
+    _pieces[RED] = pieces[RED];
+    _pieces[YELLOW] = pieces[YELLOW];
+    _kings = kings;
+    _playerToMove = playerToMove;
+    return true;
+}
+
+void CheckersPosition::setPieces(uint32_t red, uint32_t yellow, uint32_t kings, int playerToMove)
+{
+    _pieces[RED] = red;
+    _pieces[YELLOW] = yellow;
+    _kings = kings;
+    _playerToMove = playerToMove;
+}
+
+std::string CheckersPosition::state() const
+{
+    std::string state(SQUARES, '0');
+    for (int s = 0; s < SQUARES; s++) {
+        state[s] = (char)('0' + piece(s));
+    }
+    return state;
+}
+
+int CheckersPosition::piece(int square) const
+{
+    uint32_t bit = 1u << square;
+    bool king = (_kings & bit) != 0;
+    if (_pieces[RED] & bit) return king ? RED_KING : RED_MAN;
+    if (_pieces[YELLOW] & bit) return king ? YELLOW_KING : YELLOW_MAN;
+    return EMPTY;
+}
+
+int CheckersPosition::squareX(int square)
+{
+    // even rows (from the top) start on a light square
+    int y = square / 4;
+    return 2 * (square % 4) + ((y % 2 == 0) ? 1 : 0);
+}
+
+int CheckersPosition::squareAt(int x, int y)
+{
+    if (x < 0 || x > 7 || y < 0 || y > 7 || (x + y) % 2 == 0) return -1;
+    return y * 4 + x / 2;
+}
+
+int CheckersPosition::owner(int piece)
+{
+    if (piece == RED_MAN || piece == RED_KING) return RED;
+    if (piece == YELLOW_MAN || piece == YELLOW_KING) return YELLOW;
+    return -1;
+}
+
+// the side to move's pieces that have a jump: step to a landing square over an opponent
+// and step back twice to find where it came from
+uint32_t CheckersPosition::jumpers() const
+{
+    uint32_t mine = _pieces[_playerToMove];
+    uint32_t theirs = _pieces[1 - _playerToMove];
+    uint32_t empty = this->empty();
+
+    uint32_t jumping = 0;
+    for (int d = 0; d < 4; d++) {
+        uint32_t movers = isForward(_playerToMove, d) ? mine : (mine & _kings);
+        uint32_t landings = step(step(movers, d) & theirs, d) & empty;
+        jumping |= step(step(landings, 3 - d), 3 - d) & movers;
+    }
+    return jumping;
+}
+
+//
+// extend a capture chain from {square}, adding every finished chain to {moves}
+// captured pieces stay on the board until the move is over, so they block but can't be taken
+// twice. {empty} has the square the chain started from in it, the jumping piece has left it
+//
+void CheckersPosition::addJumps(int square, bool king, uint32_t empty, const Move &move, std::vector<Move> &moves) const
+{
+    uint32_t theirs = _pieces[1 - _playerToMove] & ~move.captured;
+    uint32_t bit = 1u << square;
+    bool extended = false;
+
+    for (int d = 0; d < 4; d++) {
+        if (!king && !isForward(_playerToMove, d)) continue;
+        uint32_t middle = step(bit, d) & theirs;
+        uint32_t landing = step(middle, d) & empty;
+        if (!landing) continue;
+
+        int to = std::countr_zero(landing);
+        Move next = move;
+        next.path[next.jumps++] = (int8_t)to;
+        next.to = (int8_t)to;
+        next.captured |= middle;
+        next.capturedKings |= middle & _kings;
+        extended = true;
+
+        if (!king && (landing & promotionRow(_playerToMove))) {
+            next.promotes = true;
+            moves.push_back(next);  // crowning ends the move
+        } else {
+            addJumps(to, king, empty, next, moves);
+        }
+    }
+
+    if (!extended && move.jumps > 0) {
+        moves.push_back(move);
+    }
+}
+
+void CheckersPosition::generateMoves(std::vector<Move> &moves) const
+{
+    moves.clear();
+    uint32_t mine = _pieces[_playerToMove];
+    uint32_t empty = this->empty();
+
+    // captures are forced, so if there are any they're the only legal moves
+    uint32_t jumping = jumpers();
+    if (jumping) {
+        for (; jumping; jumping &= jumping - 1) {
+            int square = std::countr_zero(jumping);
+            uint32_t bit = 1u << square;
+            Move move = {(int8_t)square, (int8_t)square, 0, {}, 0, 0, false};
+            addJumps(square, (_kings & bit) != 0, empty | bit, move, moves);
+        }
+        return;
+    }
+
+    // simple moves, one direction at a time for every piece at once
+    for (int d = 0; d < 4; d++) {
+        uint32_t movers = isForward(_playerToMove, d) ? mine : (mine & _kings);
+        for (uint32_t targets = step(movers, d) & empty; targets; targets &= targets - 1) {
+            int to = std::countr_zero(targets);
+            uint32_t from = step(1u << to, 3 - d);
+            bool promotes = !(from & _kings) && ((1u << to) & promotionRow(_playerToMove));
+            Move move = {(int8_t)std::countr_zero(from), (int8_t)to, 0, {}, 0, 0, promotes};
+            moves.push_back(move);
+        }
+    }
+}
+
+// a king can capture its way back round to the square it started on, so from and to may be the same
+void CheckersPosition::play(const Move &move)
+{
+    uint32_t from = 1u << move.from;
+    uint32_t to = 1u << move.to;
+    bool king = (_kings & from) || move.promotes;
+
+    _pieces[_playerToMove] = (_pieces[_playerToMove] & ~from) | to;
+    _kings &= ~from;
+    if (king) _kings |= to;
+
+    _pieces[1 - _playerToMove] &= ~move.captured;
+    _kings &= ~move.captured;
+    _playerToMove = 1 - _playerToMove;
+}
+
+void CheckersPosition::undo(const Move &move)
+{
+    _playerToMove = 1 - _playerToMove;
+    uint32_t from = 1u << move.from;
+    uint32_t to = 1u << move.to;
+    bool king = (_kings & to) && !move.promotes;
+
+    _pieces[_playerToMove] = (_pieces[_playerToMove] & ~to) | from;
+    _kings &= ~to;
+    if (king) _kings |= from;
+
+    _pieces[1 - _playerToMove] |= move.captured;
+    _kings |= move.capturedKings;
+}
+
+int CheckersPosition::mobility(int player) const
+{
+    uint32_t mine = _pieces[player];
+    uint32_t empty = this->empty();
+    int count = 0;
+    for (int d = 0; d < 4; d++) {
+        uint32_t movers = isForward(player, d) ? mine : (mine & _kings);
+        count += std::popcount(step(movers, d) & empty);
+    }
+    return count;
+}
+
+bool CheckersPosition::isLost() const
+{
+    if (jumpers()) return false;
+
+    uint32_t mine = _pieces[_playerToMove];
+    uint32_t empty = this->empty();
+    for (int d = 0; d < 4; d++) {
+        uint32_t movers = isForward(_playerToMove, d) ? mine : (mine & _kings);
+        if (step(movers, d) & empty) return false;
+    }
+    return true;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//
+// checkers position on the 32 dark squares, independent of the gui
+//
+// squares are numbered in the order Grid::getStateString() visits the enabled squares:
+// row by row from the top, left to right, so square s sits on row s / 4.
+// red starts on rows 0-2 and moves down the board, yellow starts on rows 5-7 and moves up.
+// red moves first, and the piece codes match the Checkers game tags
+//
+// the board is three 32-bit bitboards, one bit per square: each side's pieces and the kings.
+// a diagonal step is a shift by 3, 4 or 5 depending on the direction and on whether the row
+// starts on a light or a dark square, so simple moves for every piece come out of one shift
+// and mask per direction. capture chains are followed square by square from the pieces that
+// have a first jump
+//
+class CheckersPosition
+{
+public:
+    enum Piece
+    {
+        EMPTY = 0,
+        RED_MAN = 1,
+        RED_KING = 2,
+        YELLOW_MAN = 3,
+        YELLOW_KING = 4
+    };
+
+    static const int SQUARES = 32;
+    static const int RED = 0;
+    static const int YELLOW = 1;
+    static const int MAX_JUMPS = 12;    // a piece can't take more than the 12 it's up against
+
+    struct Move
+    {
+        int8_t      from;
+        int8_t      to;
+        uint8_t     jumps;              // 0 for a plain move
+        int8_t      path[MAX_JUMPS];    // landing square after each jump
+        uint32_t    captured;           // one bit per captured square
+        uint32_t    capturedKings;      // the captured pieces that were kings, for undo()
+        bool        promotes;
+    };
+
+    CheckersPosition();
+
+    // the starting position
+    void        reset();
+
+    // load a Checkers state string, one '0'-'4' per square, false if it's malformed
+    bool        setState(const std::string &state, int playerToMove);
+    std::string state() const;
+    // set the bitboards directly, {kings} is a subset of the two sides' pieces
+    void        setPieces(uint32_t red, uint32_t yellow, uint32_t kings, int playerToMove);
+
+    int         piece(int square) const;
+    int         playerToMove() const { return _playerToMove; }
+    int         pieceCount(int player) const { return std::popcount(_pieces[player]); }
+
+    // the bitboards
+    uint32_t    pieces(int player) const { return _pieces[player]; }
+    uint32_t    kings() const { return _kings; }
+    uint32_t    empty() const { return ~(_pieces[RED] | _pieces[YELLOW]); }
+
+    // every legal move: captures are forced, and a capture has to be followed to the end
+    // of the chain. a man that reaches the far row is crowned and its move ends there
+    void        generateMoves(std::vector<Move> &moves) const;
+    void        play(const Move &move);
+    // take back the last move played, which has to be {move}
+    void        undo(const Move &move);
+
+    // the side to move has nothing left to move and has lost
+    bool        isLost() const;
+    // the side to move has a capture, and so has to take
+    bool        mustCapture() const { return jumpers() != 0; }
+    // how many plain moves {player} would have, ignoring forced captures
+    int         mobility(int player) const;
+
+    static int  squareX(int square);
+    static int  squareY(int square) { return square / 4; }
+    static int  squareAt(int x, int y);     // -1 for a light square or off the board
+    static int  owner(int piece);           // RED, YELLOW or -1 for EMPTY
+    static bool isKing(int piece) { return piece == RED_KING || piece == YELLOW_KING; }
+
+private:
+    uint32_t    jumpers() const;
+    void        addJumps(int square, bool king, uint32_t empty, const Move &move, std::vector<Move> &moves) const;
+
+    uint32_t    _pieces[2];     // red, yellow
+    uint32_t    _kings;
+    int         _playerToMove;
+};
@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <bit>
+#include "CheckersSearch.h"
+
+static const uint32_t TOP_ROW = 0x0000000fu;
+static const uint32_t BOTTOM_ROW = 0xf0000000u;
+
+// evaluation weights
+static const int MAN_VALUE = 100;
+static const int KING_VALUE = 140;
+static const int BACK_RANK_WEIGHT = 12;     // men left at home keep the opponent from crowning
+static const int ADVANCE_WEIGHT = 3;        // per row a man has come up the board
+static const int MOBILITY_WEIGHT = 3;
+static const int CHASE_WEIGHT = 4;          // per square between a king of the side that's ahead and its prey
+static const int CHASE_PIECES = 10;         // only with this many pieces or fewer left
+static const int EVAL_LIMIT = Search<CheckersSearchPosition>::EVAL_LIMIT;   // evaluate stays inside this, below the database
+
+CheckersSearch::CheckersSearch()
+{
+    _search.setTimeBudget(SEARCH_TIME_MS);
+    _search.setMaxDepth(MAX_DEPTH);
+    _endgame = nullptr;
+}
+
+static uint64_t mix(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+uint64_t CheckersSearch::positionKey(const CheckersPosition &position)
+{
+    uint64_t pieces = position.pieces(CheckersPosition::RED) |
+                      ((uint64_t)position.pieces(CheckersPosition::YELLOW) << 32);
+    uint64_t kings = ((uint64_t)position.kings() << 1) | (uint64_t)position.playerToMove();
+    return mix(pieces) ^ mix(kings + 0x9e3779b97f4a7c15ULL);
+}
+
+// one side's share of the evaluation
+static int sideScore(const CheckersPosition &position, int player)
+{
+    uint32_t pieces = position.pieces(player);
+    uint32_t kings = pieces & position.kings();
+    uint32_t men = pieces & ~kings;
+
+    int score = MAN_VALUE * std::popcount(men) + KING_VALUE * std::popcount(kings);
+
+    // red men start at the top and move down, yellow the other way
+    bool red = (player == CheckersPosition::RED);
+    score += BACK_RANK_WEIGHT * std::popcount(men & (red ? TOP_ROW : BOTTOM_ROW));
+    for (int row = 1; row < 7; row++) {
+        int advanced = red ? row : 7 - row;
+        score += ADVANCE_WEIGHT * advanced * std::popcount(men & (TOP_ROW << (4 * row)));
+    }
+
+    score += MOBILITY_WEIGHT * position.mobility(player);
+    return score;
+}
+
+//
+// once the board has thinned out, the side that's ahead has to go and get the other side's
+// pieces: material alone lets its kings wander, so they pay for how far they are from the
+// nearest enemy piece. from the point of view of {player}, who's ahead
+//
+static int chaseScore(const CheckersPosition &position, int player)
+{
+    uint32_t prey = position.pieces(1 - player);
+    int score = 0;
+    for (uint32_t kings = position.pieces(player) & position.kings(); kings; kings &= kings - 1) {
+        int square = std::countr_zero(kings);
+        int nearest = 7;
+        for (uint32_t target = prey; target; target &= target - 1) {
+            int other = std::countr_zero(target);
+            int distance = std::max(std::abs(CheckersPosition::squareX(square) - CheckersPosition::squareX(other)),
+                                    std::abs(CheckersPosition::squareY(square) - CheckersPosition::squareY(other)));
+            nearest = std::min(nearest, distance);
+        }
+        score -= CHASE_WEIGHT * nearest;
+    }
+    return score;
+}
+
+int CheckersSearch::evaluate(const CheckersPosition &position)
+{
+    int player = position.playerToMove();
+    int score = sideScore(position, player) - sideScore(position, 1 - player);
+
+    int mine = position.pieceCount(player);
+    int theirs = position.pieceCount(1 - player);
+    if (mine + theirs <= CHASE_PIECES && mine != theirs) {
+        score += (mine > theirs) ? chaseScore(position, player) : -chaseScore(position, 1 - player);
+    }
+    return std::clamp(score, 1 - EVAL_LIMIT, EVAL_LIMIT - 1);
+}
+
+//
+// the position for Search<Position>
+//
+
+// captures by how much they take, then crowning moves
+int CheckersSearchPosition::orderHint(const Move &move) const
+{
+    if (move.jumps > 0) {
+        return 2 + 2 * std::popcount(move.captured) + std::popcount(move.capturedKings);
+    }
+    return move.promotes ? 1 : 0;
+}
+
+// the database's value for _position if it has one. a won position scores a little better
+// the more the evaluation likes it, so the search doesn't just shuffle around inside the win
+bool CheckersSearchPosition::probeEndgame(int &score) const
+{
+    int value = _endgame->probe(_position);
+    if (value == CheckersEndgame::UNKNOWN) {
+        return false;
+    }
+    int progress = CheckersSearch::evaluate(_position) / 8;
+    if (value == CheckersEndgame::WIN) score = CheckersSearch::DATABASE_WIN + progress;
+    else if (value == CheckersEndgame::LOSS) score = -CheckersSearch::DATABASE_WIN + progress;
+    else score = 0;
+    return true;
+}
+
+//
+// decide what the database is used for in this search, and if the root is in it, keep only
+// the root moves that hold on to its result
+//
+void CheckersSearchPosition::prepareRoot(std::vector<Move> &moves)
+{
+    int pieces = _position.pieceCount(CheckersPosition::RED) + _position.pieceCount(CheckersPosition::YELLOW);
+    _probePieces = 0;
+    if (!_endgame) {
+        return;
+    }
+    if (pieces > _endgame->maxPieces()) {
+        _probePieces = _endgame->maxPieces();
+        return;
+    }
+    _probePieces = pieces - 1;
+
+    // the value of each move for us is the opposite of the opponent's after it
+    static const int forUs[3] = {CheckersEndgame::DRAW, CheckersEndgame::LOSS, CheckersEndgame::WIN};
+    int rootValue = _endgame->probe(_position);
+    if (rootValue == CheckersEndgame::UNKNOWN) {
+        return;
+    }
+    std::vector<Move> kept;
+    for (const Move &move : moves) {
+        _position.play(move);
+        int value = _endgame->probe(_position);
+        _position.undo(move);
+        if (value != CheckersEndgame::UNKNOWN && forUs[value] == rootValue) {
+            kept.push_back(move);
+        }
+    }
+    if (!kept.empty()) {
+        moves.swap(kept);
+    }
+}
+
+//
+// search
+//
+
+// scores with and without the database don't mean the same thing, so the table starts over
+void CheckersSearch::setEndgame(const CheckersEndgame *endgame)
+{
+    _endgame = (endgame && endgame->isOpen()) ? endgame : nullptr;
+    _search.clearTranspositionTable();
+}
+
+int CheckersSearch::findBestMove(const CheckersPosition &position, const std::atomic<bool> *cancel)
+{
+    CheckersPosition::Move best;
+    if (!_search.findBestMove(CheckersSearchPosition(position, _endgame), best, cancel)) {
+        return -1;
+    }
+    std::vector<CheckersPosition::Move> moves;
+    position.generateMoves(moves);
+    for (size_t i = 0; i < moves.size(); i++) {
+        if (moves[i].from == best.from && moves[i].to == best.to && moves[i].captured == best.captured) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <vector>
+#include "CheckersPosition.h"
+#include "CheckersEndgame.h"
+#include "Search.h"
+
+//
+// the checkers position dressed up for Search<Position> (see Search.h and SearchPositions.h)
+//
+// the engine's evaluation, and captures are forced so a leaf is only quiet once nobody has one.
+// with an endgame database, positions past the root with few enough pieces are looked up
+// instead of searched, and score DATABASE_WIN plus a little of the evaluation for a win.
+// a root that's in the database itself only keeps the moves that hold on to its result, and
+// only looks up positions with fewer pieces, so the search still has to find the way to
+// convert a win rather than shuffle around inside it.
+// it lives here rather than with the others because CheckersSearch is built on it
+//
+class CheckersSearchPosition
+{
+public:
+    typedef CheckersPosition::Move Move;
+    static const int MOVE_IDS = CheckersPosition::SQUARES * CheckersPosition::SQUARES;
+
+    CheckersSearchPosition() : _endgame(nullptr), _probePieces(0) {}
+    // the database, if there is one, has to outlive the position
+    explicit CheckersSearchPosition(const CheckersPosition &position, const CheckersEndgame *endgame = nullptr)
+        : _position(position), _endgame(endgame), _probePieces(0) {}
+
+    void        generate(std::vector<Move> &moves) const { _position.generateMoves(moves); }
+    void        play(const Move &move) { _position.play(move); }
+    void        undo(const Move &move) { _position.undo(move); }
+    uint64_t    key() const;
+    int         evaluate() const;
+    bool        terminal(int &margin) const
+    {
+        margin = _position.isLost() ? -1 : 0;
+        return margin != 0;
+    }
+    int         moveId(const Move &move) const { return move.from * CheckersPosition::SQUARES + move.to; }
+    int         orderHint(const Move &move) const;
+    bool        forcing() const { return _position.mustCapture(); }
+    int         playerToMove() const { return _position.playerToMove(); }
+    bool        lookup(int &score) const
+    {
+        if (_position.pieceCount(CheckersPosition::RED) + _position.pieceCount(CheckersPosition::YELLOW) > _probePieces) {
+            return false;
+        }
+        return probeEndgame(score);
+    }
+    void        prepareRoot(std::vector<Move> &moves);
+
+    const CheckersPosition &position() const { return _position; }
+
+private:
+    bool        probeEndgame(int &score) const;
+
+    CheckersPosition _position;
+    const CheckersEndgame *_endgame;
+    int         _probePieces;       // look up positions with this many pieces or fewer
+};
+
+//
+// checkers search engine, independent of the gui so it can run on a worker thread
+//
+// Search<CheckersSearchPosition> does the searching: negamax with alpha-beta and iterative
+// deepening, a transposition table, killer and history move ordering and a time budget, and
+// forced captures played out past the horizon. this keeps the engine's settings and its
+// evaluation, and hands its moves out the way the game wants them
+// moves are identified by their index in the list CheckersPosition::generateMoves makes
+//
+class CheckersSearch
+{
+public:
+    CheckersSearch();
+
+    // pick a move for the side to move, as an index into position.generateMoves(), -1 if there's none
+    int         findBestMove(const CheckersPosition &position, const std::atomic<bool> *cancel = nullptr);
+
+    // settings
+    void        setTimeBudget(int milliseconds) { _search.setTimeBudget(milliseconds); }
+    void        setMaxDepth(int depth) { _search.setMaxDepth(depth < MAX_DEPTH ? depth : MAX_DEPTH); }
+    void        setTranspositionTableSize(size_t megabytes) { _search.setTranspositionTableSize(megabytes); }
+    // look positions up in this database, which has to outlive the search. nullptr or a
+    // closed one searches everything
+    void        setEndgame(const CheckersEndgame *endgame);
+    // wipe the table, so a search doesn't depend on the ones before it
+    void        clearTranspositionTable() { _search.clearTranspositionTable(); }
+
+    // statistics from the last search
+    uint64_t    getNodesSearched() const { return _search.getNodesSearched(); }
+    int         getCompletedDepth() const { return _search.getCompletedDepth(); }
+    int         getBestScore() const { return _search.getBestScore(); }
+
+    static uint64_t positionKey(const CheckersPosition &position);
+
+    // static evaluation from the side to move's point of view: material, kings, back rank,
+    // advancement and mobility
+    static int      evaluate(const CheckersPosition &position);
+
+    static const int WINNING_SCORE = Search<CheckersSearchPosition>::WINNING_SCORE;
+    static const int SEARCH_TIME_MS = 500;  // default time budget for one AI move
+    static const int MAX_DEPTH = 64;
+    static const int DATABASE_WIN = 8000;   // below any win the search sees itself
+
+private:
+    Search<CheckersSearchPosition> _search;
+    const CheckersEndgame *_endgame;
+};
+
+inline uint64_t CheckersSearchPosition::key() const { return CheckersSearch::positionKey(_position); }
+inline int CheckersSearchPosition::evaluate() const { return CheckersSearch::evaluate(_position); }
@@ -6,12 +6,19 @@ Logger *logger = Logger::GetInstance();
 
 const int SQUARE_SIZE = 80;
 
-// trying a bitboard
-uint64_t RED_BOARD;
-uint64_t YELLOW_BOARD;
-
 Connect4::Connect4() : Game() {
     _grid = new Grid(7, 6);
+    _search.setThreads((int)std::thread::hardware_concurrency());
+    _monteCarloSearch.setThreads((int)std::thread::hardware_concurrency());
+    _solver.setTimeBudget(SOLVER_TIME_MS);
+    _solver.setCancelFlag(&_aiCancel);
+    _perfectPlay = false;
+    _monteCarlo = false;
+    _aiSearched = false;
+    _playoutRate = 0;
+    if (!_book.open(Connect4Book::DEFAULT_FILE)) {
+        logger->Log(std::string("no opening book at ") + Connect4Book::DEFAULT_FILE + ", build it with the connect4_book target", logger->WARN, logger->GAME);
+    }
     setNumberOfPlayers(2);
 }
 
@@ -28,16 +35,13 @@ void Connect4::setUpBoard() {
     _grid->initializeSquares(SQUARE_SIZE, "square.png");
 
     // init bitboard representations 
-    RED_BOARD = 0;
-    YELLOW_BOARD = 0;
+    _position.reset();
 
     // TEMP
     // TODO: let play choose
     if (gameHasAI()) {
         AI_COLOR = (_gameOptions.AIPlayer == 0) ? RED_PIECE : YELLOW_PIECE;
-        AI_BOARD = (_gameOptions.AIPlayer == 0) ? &RED_BOARD : &YELLOW_BOARD;
         HUMAN_COLOR = (_gameOptions.AIPlayer == 1) ? RED_PIECE : YELLOW_PIECE;
-        HUMAN_BOARD = (_gameOptions.AIPlayer == 1) ? &RED_BOARD : &YELLOW_BOARD;
     }
 
     startGame();
@@ -67,59 +71,23 @@ ImVec2 convertPixelCoords(ImVec2 grid_pos){
     );
 }
 
-bool inRange(int num, int min, int max){
-    return (num >= min && num <= max);
-}
-
-// https://jorrid.com/posts/the-wondrous-world-of-connect-four-bit-boards/
-bool Connect4::updateBitboard(int column){
-    uint64_t &PLAYER_BOARD = (getCurrentPlayer()->playerNumber() == RED_PLAYER) ? RED_BOARD : YELLOW_BOARD;
-    uint64_t &OTHER_BOARD = (getCurrentPlayer()->playerNumber() == RED_PLAYER) ? YELLOW_BOARD : RED_BOARD;
-
-    return updateBitboard(column, PLAYER_BOARD, OTHER_BOARD);
-}
-
-bool Connect4::updateBitboard(int column, uint64_t &PLAYER_BOARD, uint64_t &OTHER_BOARD){
-    // set up masks
-    uint64_t filled = PLAYER_BOARD | OTHER_BOARD;   // all occupied spaces
-    uint64_t col0 = 0x3f;                           // first col (0, 1, 2, 3, 4, 5)
-    uint64_t row0 = 0x40201008040201;               // first row (0, 7, 14, 21, 28, 35, 42)
-    uint64_t open = col0 * row0;                    // all open spaces
-
-    // the most important mask, where can the piece go next?
-    uint64_t VALID = (filled + row0) & open;        // the lowest available space of each column
-    uint64_t to_column = col0 << (column * 9);      // the column where we're moving
-    uint64_t move = VALID & to_column;              // our move
-
-    if(move == 0){
-        return false;   // no valid moves in this column
-    }
-
-    // update player bitboard
-    PLAYER_BOARD |= move;
-    return true;
-}
-
 bool Connect4::actionForEmptyHolder(BitHolder &holder)
 {
     // TODO: currently, this only works if the player clicks on an empty holder, but i'd like
     //       for it to work as long as player is hovered over a column with an empty holder
 
-    int dir = (holder.empty()) ? 1 : -1;    // look down if holder is empty and up if not
+    ImVec2 pos = convertToGridCoords(holder.getPosition());
+    int column = (int)pos.x;
+    if(!_position.canPlay(column)){
+        return false;   // no valid moves in this column
+    }
 
     Bit *bit = createPiece(getCurrentPlayer()->playerNumber() == RED_PLAYER ? RED_PIECE : YELLOW_PIECE);
     if (bit) {
-        ImVec2 pos = convertToGridCoords(holder.getPosition());
-        if(!updateBitboard((int)pos.x)){ // pass column being dropped into
-            return false;
-        } 
-
-        // find lowest empty neighbor in this column
-        while(inRange((int)pos.y + dir, 0, _gameOptions.rowY - 1) && getHolderAt((int)pos.x, (int)pos.y + 1).empty()){
-            pos.y += dir;
-        }
+        // the column height says where the piece lands, grid rows count down from the top
+        pos.y = (float)(_gameOptions.rowY - 1 - _position.height(column));
+        _position.play(column);
 
-        // update player bitboard
         BitHolder &neighbor = getHolderAt((int)pos.x, (int)pos.y);
         bit->setPosition(convertPixelCoords(pos));
         neighbor.setBit(bit);
@@ -173,10 +141,10 @@ bool Connect4::bitWin(uint64_t board){
 }
 
 Player* Connect4::checkForWinner() {
-    if(bitWin(RED_BOARD)){
+    if(bitWin(_position.board(RED_PLAYER))){
         return getPlayerAt(RED_PLAYER);
     }
-    if(bitWin(YELLOW_BOARD)){
+    if(bitWin(_position.board(YELLOW_PLAYER))){
         return getPlayerAt(YELLOW_PLAYER);
     }
 
@@ -184,10 +152,11 @@ Player* Connect4::checkForWinner() {
 }
 
 bool Connect4::checkForDraw() {
-    return bitCheckForFullBoard(RED_BOARD | YELLOW_BOARD);
+    return bitCheckForFullBoard(_position.filled());
 }
 
 void Connect4::stopGame() {
+    cancelAISearch();
     _grid->forEachSquare([](ChessSquare* square, int x, int y) {
         square->destroyBit();
     });
@@ -211,164 +180,187 @@ void Connect4::setStateString(const std::string &s) {
 }
 
 //
-// this is the function that will be called by the AI
+// undo
 //
-void Connect4::updateAI()
+
+// pull the top piece out of the last column played and hand the turn back
+bool Connect4::undoOneMove()
 {
-    // don't try to play if game over
-    if (checkForDraw() || checkForWinner())
-    {
-        return;
+    if(!_position.canUndo()){
+        return false;
     }
-    
-    // get current board state
-    std::string state = stateString();
 
-    // find next move
-    int move = getNextMove(state);
+    int column = _position.undo();
+    getHolderAt(column, _gameOptions.rowY - 1 - _position.height(column)).destroyBit();
 
-    if(move != -1){
-        actionForEmptyHolder(getHolderAt(move, 0));
+    delete _turns.back();
+    _turns.pop_back();
+    _gameOptions.currentTurnNo--;
+    return true;
+}
+
+bool Connect4::undoMove()
+{
+    cancelAISearch();
+    if(!undoOneMove()){
+        return false;
     }
-    else {
-        logger->Log("AI turn failed: move not found", logger->ERROR, logger->GAME);
-        // moving randomly in this case...
-        move = (int)(std::rand() % _gameOptions.rowX);
-        actionForEmptyHolder(getHolderAt(move, 0));
+    // against the AI, take its reply back too
+    if(gameHasAI() && getCurrentPlayer()->isAIPlayer()){
+        undoOneMove();
     }
+    return true;
 }
 
-int Connect4::getNextMove(std::string &state){
-    int bestMove = -1000;
-    int bestColumn = -1;
-
-    uint64_t red_backup = RED_BOARD;
-    uint64_t yellow_backup = YELLOW_BOARD;
-    int currentPlayer = (getCurrentPlayer()->playerNumber() == _gameOptions.AIPlayer) ? AI_PLAYER : HUMAN_PLAYER;
-
-    for(int i = 0; i < _gameOptions.rowX; i++){
-        int col = MOVE_ORDER[i];
-        if(!updateBitboard(col)){ // no available spaces in this column, move on
-            continue;
-        }
+//
+// snapshot the position and search it on a worker thread
+//
+std::future<int> Connect4::startAISearch()
+{
+    // don't try to play if game over
+    if (checkForDraw() || checkForWinner())
+    {
+        return std::future<int>();
+    }
 
-        int score = -negamax(0, -WINNING_SCORE, WINNING_SCORE, -currentPlayer);
+    Connect4Position position = _position;
 
-        if(score > bestMove){
-            bestMove = score;
-            bestColumn = col;
-        }
+    return std::async(std::launch::async, [this, position]() {
+        return getNextMove(position);
+    });
+}
 
-        RED_BOARD = red_backup;
-        YELLOW_BOARD = yellow_backup;
+//
+// search on the human's turn. the heuristic search takes the reply its last principal variation
+// expects and searches the position after it. the monte carlo search searches the position the
+// human has in front of them, so whatever they play its tree has a subtree for it
+//
+std::future<int> Connect4::startPonder()
+{
+    if (_perfectPlay || checkForDraw() || checkForWinner())
+    {
+        return std::future<int>();
     }
 
-    return bestColumn;
-}
-
-bool Connect4::bitCheckForFullBoard(uint64_t state){
-    uint64_t col0 = 0x3f;                           // first col (0, 1, 2, 3, 4, 5)
-    uint64_t row0 = 0x40201008040201;               // first row (0, 7, 14, 21, 28, 35, 42)
-    uint64_t all = col0 * row0;                    // all spaces
+    if (_monteCarlo) {
+        Connect4Position position = _position;
+        _ponderPosition = Connect4Position();
+        return std::async(std::launch::async, [this, position]() {
+            int move = -1;
+            _monteCarloSearch.setVisitTarget(0);
+            _monteCarloSearch.findBestMove(Connect4SearchPosition(position), move, &_ponderStop, PONDER_TIME_MS);
+            if (_monteCarloSearch.getPlayouts() > 0) {
+                _playoutRate = _monteCarloSearch.getPlayoutsPerSecond();
+            }
+            return move;
+        });
+    }
 
-    if(state == all){ 
-        return true;
+    // the principal variation starts with the AI's own move, the human's reply is next
+    const std::vector<int> &line = _search.getPrincipalVariation();
+    if (!_aiSearched || line.size() < 2 || !_position.canPlay(line[1]))
+    {
+        return std::future<int>();
     }
-    return false;
+    _ponderPosition = _position;
+    _ponderPosition.play(line[1]);
+    if (Connect4Search::isWin(_ponderPosition.opponent()) || _ponderPosition.isFull())
+    {
+        return std::future<int>();
+    }
+
+    Connect4Position position = _ponderPosition;
+    return std::async(std::launch::async, [this, position]() {
+        int move, score;
+        _aiSearched = false;
+        if (_book.lookup(position.current(), position.opponent(), move, score)) {
+            return move;
+        }
+        _aiSearched = true;
+        return _search.findBestMove(position, &_ponderStop, PONDER_TIME_MS);
+    });
 }
 
-int countBits(uint64_t board){
-    int count = 0;
-    while (board) {
-        board &= (board - 1);
-        count++;
-    }
-    return count;
+// the monte carlo search never hits, its tree is picked up by the search that follows
+bool Connect4::ponderHit()
+{
+    return !_monteCarlo && _ponderPosition.moveCount() > 0 && _ponderPosition.key() == _position.key();
 }
 
-// TODO: replace with eval fucntion that score different states
-int Connect4::eval(uint64_t myBoard, uint64_t oppBoard){
-    int score = 0;
-    
-    // my advantage
-    // score center bits
-    uint64_t center = 0x3f << (2 * 9);
-    score += countBits(center & myBoard) * 3;
-    center = 0x3f << (3 * 9);   
-    score += countBits(center & myBoard) * 5;    // true center
-    center = 0x3f << (4 * 9);
-    score += countBits(center & myBoard) * 3;
-
-    // if(bitRow(myBoard, 4)){
-        // score += WINNING_SCORE * 10; // 4 in a row = win!
-    // } 
-    if(bitRow(myBoard, 3)){
-        score += 1000;   // 3 in a row = strong advantage
-    }
-    else if(bitRow(myBoard, 2)){
-        score += 10;    
+//
+// back on the main thread with the search result
+//
+void Connect4::applyAIMove(int move)
+{
+    // the expected line as columns counted from 1 at the left, like the board shows them
+    _aiLine.clear();
+    if (_aiSearched && _monteCarlo) {
+        for (int column : _monteCarloSearch.getPrincipalVariation()) {
+            _aiLine += (_aiLine.empty() ? "" : " ") + std::to_string(column + 1);
+        }
+        logger->Log("AI ran " + std::to_string(_monteCarloSearch.getPlayouts()) + " playouts (" + std::to_string((int)_monteCarloSearch.getPlayoutsPerSecond()) + " a second), expecting " + _aiLine, logger->INFO, logger->GAME);
     }
-    else {
-        score -= 100;   // punish isolated pieces
+    else if (_aiSearched) {
+        for (int column : _search.getPrincipalVariation()) {
+            _aiLine += (_aiLine.empty() ? "" : " ") + std::to_string(column + 1);
+        }
+        logger->Log("AI searched " + std::to_string(_search.getNodesSearched()) + " nodes to depth " + std::to_string(_search.getCompletedDepth()) + ", expecting " + _aiLine, logger->INFO, logger->GAME);
     }
 
-    // opp advantage
-    // if(bitRow(oppBoard, 4)){
-        // score -= WINNING_SCORE * 10;
-    // } 
-    if(bitRow(oppBoard, 3)){
-        score -= 2000;
-    }
-    else if(bitRow(oppBoard, 2)){
-        score -= 100;
+    if(move != -1){
+        actionForEmptyHolder(getHolderAt(move, 0));
     }
     else {
-        score += 10;
+        logger->Log("AI turn failed: move not found", logger->ERROR, logger->GAME);
+        // moving randomly in this case...
+        move = (int)(std::rand() % _gameOptions.rowX);
+        actionForEmptyHolder(getHolderAt(move, 0));
     }
-
-    return score;
 }
 
-int Connect4::negamax(int depth, int alpha, int beta, int player){
-    uint64_t &myBoard = player == HUMAN_PLAYER ? *HUMAN_BOARD : *AI_BOARD;
-    uint64_t &oppBoard = player == HUMAN_PLAYER? *AI_BOARD : *HUMAN_BOARD;
-
-    // check terminals
-    if(bitWin(myBoard)) return WINNING_SCORE / (1 + depth);
-    if(bitWin(oppBoard)) return -(WINNING_SCORE / (1 + depth));
-    if(depth >= MAX_DEPTH) return eval(myBoard, oppBoard);
+int Connect4::getNextMove(const Connect4Position &position){
+    uint64_t myBoard = position.current();
+    uint64_t oppBoard = position.opponent();
+    int score = 0;
+    int move = -1;
+    _aiSearched = false;
 
-    // check for draw
-    if (bitCheckForFullBoard(myBoard | oppBoard)) { 
-        return 0;
+    // the opening book has solved moves for the widest, most expensive part of the tree
+    if(_book.lookup(myBoard, oppBoard, move, score)){
+        return move;
     }
 
-    int bestValue = -WINNING_SCORE * 100;
-
-    uint64_t &PLAYER_BOARD = (player == AI_PLAYER) ? *AI_BOARD : *HUMAN_BOARD;
-    uint64_t &OTHER_BOARD = (player == AI_PLAYER) ? *HUMAN_BOARD : *AI_BOARD;
-
-    uint64_t red_backup = RED_BOARD;
-    uint64_t yellow_backup = YELLOW_BOARD;
-
-    for(int i = 0; i < _gameOptions.rowX; i++){
-        int col = MOVE_ORDER[i];
-        if(!updateBitboard(col, PLAYER_BOARD, OTHER_BOARD)){ // no available spaces in this column, move on
-            continue;
+    if(_perfectPlay){
+        move = _solver.bestMove(myBoard, oppBoard, score);
+        if(move != -1){
+            return move;
         }
+        // too early in the game to solve in time, fall back on the heuristic search
+    }
+    _aiSearched = true;
+    if(_monteCarlo){
+        // after pondering, stop as soon as the tree is as big as a search of our own would have made it
+        _monteCarloSearch.setVisitTarget(_pondering ? (uint64_t)(_playoutRate * _monteCarloSearch.getTimeBudget() / 1000) : 0);
+        if(!_monteCarloSearch.findBestMove(Connect4SearchPosition(position), move, &_aiCancel)){
+            return -1;
+        }
+        if(_monteCarloSearch.getPlayouts() > 0){
+            _playoutRate = _monteCarloSearch.getPlayoutsPerSecond();
+        }
+        return move;
+    }
+    return _search.findBestMove(position, &_aiCancel);
+}
 
-        int newValue = -negamax(depth + 1, -beta, -alpha, -player);
-    
-        RED_BOARD = red_backup;
-        YELLOW_BOARD = yellow_backup;
-
-        bestValue = std::max(bestValue, newValue);
-        alpha = std::max(alpha, newValue);
+bool Connect4::bitCheckForFullBoard(uint64_t state){
+    uint64_t col0 = 0x3f;                           // first col (0, 1, 2, 3, 4, 5)
+    uint64_t row0 = 0x40201008040201;               // first row (0, 7, 14, 21, 28, 35, 42)
+    uint64_t all = col0 * row0;                    // all spaces
 
-        if(alpha >= beta) return bestValue;    // prune
+    if(state == all){ 
+        return true;
     }
-
-    return bestValue;
+    return false;
 }
 
 // // legacy AI (very bad, only picks at random from available holders)
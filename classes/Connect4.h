@@ -1,5 +1,11 @@
 #pragma once
 #include "Game.h"
+#include "Connect4Position.h"
+#include "Connect4Search.h"
+#include "Connect4Solver.h"
+#include "Connect4Book.h"
+#include "MonteCarloSearch.h"
+#include "SearchPositions.h"
 
 class Connect4 : public Game
 {
@@ -20,13 +26,28 @@ public:
     void        stopGame() override;
 
     // AI methods
-    void        updateAI() override;
+    std::future<int> startAISearch() override;
+    void        applyAIMove(int move) override;
+    std::string aiExpectedLine() override { return _aiLine; }
+    void        setMonteCarloAI(bool monteCarlo) override { _monteCarlo = monteCarlo; }
+    std::future<int> startPonder() override;
+    bool        ponderHit() override;
+    int         aiTimeBudget() override { return _monteCarlo ? _monteCarloSearch.getTimeBudget() : _search.getTimeBudget(); }
     bool        gameHasAI() override { return _gameOptions.AIPlayer; } // Set to true when AI is implemented
     Grid*       getGrid() override { return _grid; }
-    int         getNextMove(std::string &state);
-    int         negamax(int depth, int alpha, int beta, int player);
+    int         getNextMove(const Connect4Position &position);
     bool        bitCheckForFullBoard(uint64_t state);
-    int         eval(uint64_t myBoard, uint64_t oppBoard);
+
+    // search statistics / tuning
+    uint64_t    getNodesSearched() const { return _search.getNodesSearched(); }
+    void        setTranspositionTableSize(size_t megabytes) { _search.setTranspositionTableSize(megabytes); }
+    void        setSearchTimeBudget(int milliseconds) { _search.setTimeBudget(milliseconds); }
+    void        setSearchThreads(int threads) { _search.setThreads(threads); }
+    // take back the last move, and the AI's reply before it so it's a human's turn again
+    bool        undoMove();
+
+    // "unbeatable" difficulty: play the solver's move whenever it finishes in time
+    void        setPerfectPlay(bool perfect) { _perfectPlay = perfect; }
 
 private:
     bool hasAI = false;
@@ -42,9 +63,7 @@ private:
     static const char NULL_PLAYER = '0';
     // define these in class so player can choose which is AI
     int AI_COLOR;
-    uint64_t *AI_BOARD;
     int HUMAN_COLOR;
-    uint64_t *HUMAN_BOARD;
 
     // Constants for stride types (for checking n-in-a-row)
     const uint64_t HORIZONTAL_STRIDE = 9;
@@ -52,21 +71,29 @@ private:
     const uint64_t DOWNDIAG_STRIDE = HORIZONTAL_STRIDE - 1;
     const uint64_t UPDIAG_STRIDE = HORIZONTAL_STRIDE + 1;
     const uint64_t ALL_STRIDES[4] = {HORIZONTAL_STRIDE, VERTICAL_STRIDE, DOWNDIAG_STRIDE, UPDIAG_STRIDE};
-  
-    // consts for eval function stuff
-    const int MAX_DEPTH = 10; // max search depth
-    const int WINNING_SCORE = 10000;
-    const int MOVE_ORDER[7] = {3, 2, 4, 1, 5, 0, 6};
 
     // Helper methods
     Bit*        createPiece(int pieceType);
 
     // Board representation
     Grid*        _grid;
+    Connect4Position _position;         // bitboards and move history of the game on screen
+
+    // AI search engine, works on its own copy of the bitboards so it can run on a worker thread
+    Connect4Search _search;
+    Connect4Solver _solver;
+    Connect4Book _book;                 // memory mapped opening book, empty if the file is missing
+    bool         _perfectPlay;
+    MonteCarloSearch<Connect4SearchPosition> _monteCarloSearch;
+    bool         _monteCarlo;           // search with _monteCarloSearch instead of _search
+    bool         _aiSearched;           // the last move came from the search, not the book or the solver
+    Connect4Position _ponderPosition;   // the position the ponder search is on
+    double       _playoutRate;          // playouts a second in the last monte carlo search that ran any
+    std::string  _aiLine;               // the search's principal variation behind the last AI move
+    const int    SOLVER_TIME_MS = 3000;
 
     // helpers
-    bool updateBitboard(int column, uint64_t &PLAYER_BOARD, uint64_t &OTHER_BOARD);
-    bool updateBitboard(int column);
+    bool undoOneMove();
     bool bitRow(uint64_t board, uint64_t stride, int length);
     bool bitRow(uint64_t board, int length);    // checks for a {length} row in any dir
     bool bitWin(uint64_t board);
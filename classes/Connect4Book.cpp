@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include "Connect4Book.h"
+#include "Connect4Search.h"
+
+Connect4Book::Connect4Book()
+{
+    _keys = nullptr;
+    _entries = nullptr;
+    _count = 0;
+    _maxPly = 0;
+}
+
+Connect4Book::~Connect4Book()
+{
+    close();
+}
+
+bool Connect4Book::open(const std::string &path)
+{
+    close();
+    if (!_file.open(path)) {
+        return false;
+    }
+
+    // validate the header and that the file is as long as it claims
+    const Header *header = reinterpret_cast<const Header *>(_file.data());
+    if (_file.size() < sizeof(Header) || std::memcmp(header->magic, "C4BK", 4) != 0 || header->version != VERSION ||
+        _file.size() < sizeof(Header) + (size_t)header->count * (sizeof(uint64_t) + 2)) {
+        close();
+        return false;
+    }
+
+    const uint8_t *base = _file.data();
+    _keys = reinterpret_cast<const uint64_t *>(base + sizeof(Header));
+    _entries = base + sizeof(Header) + (size_t)header->count * sizeof(uint64_t);
+    _count = header->count;
+    _maxPly = (int)header->maxPly;
+    return true;
+}
+
+void Connect4Book::close()
+{
+    _file.close();
+    _keys = nullptr;
+    _entries = nullptr;
+    _count = 0;
+    _maxPly = 0;
+}
+
+// swap column c with column 6 - c
+uint64_t Connect4Book::mirror(uint64_t board)
+{
+    uint64_t mirrored = 0;
+    for (int c = 0; c < 7; c++) {
+        uint64_t column = (board >> (c * 9)) & 0x1ff;
+        mirrored |= column << ((6 - c) * 9);
+    }
+    return mirrored;
+}
+
+uint64_t Connect4Book::bookKey(uint64_t myBoard, uint64_t oppBoard, bool &mirrored)
+{
+    uint64_t key = Connect4Search::positionKey(myBoard, oppBoard);
+    uint64_t mirrorKey = Connect4Search::positionKey(mirror(myBoard), mirror(oppBoard));
+    mirrored = mirrorKey < key;
+    return mirrored ? mirrorKey : key;
+}
+
+bool Connect4Book::lookup(uint64_t myBoard, uint64_t oppBoard, int &column, int &score) const
+{
+    if (!_count) {
+        return false;
+    }
+
+    bool mirrored = false;
+    uint64_t key = bookKey(myBoard, oppBoard, mirrored);
+    const uint64_t *found = std::lower_bound(_keys, _keys + _count, key);
+    if (found == _keys + _count || *found != key) {
+        return false;
+    }
+
+    const uint8_t *entry = _entries + 2 * (found - _keys);
+    score = (int8_t)entry[0];
+    column = mirrored ? 6 - entry[1] : entry[1];
+    return true;
+}
+
+bool Connect4Book::write(const std::string &path, int maxPly, std::vector<Record> records)
+{
+    std::sort(records.begin(), records.end(), [](const Record &a, const Record &b) { return a.key < b.key; });
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+
+    Header header;
+    std::memcpy(header.magic, "C4BK", 4);
+    header.version = VERSION;
+    header.maxPly = (uint32_t)maxPly;
+    header.count = (uint32_t)records.size();
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    for (const Record &record : records) {
+        file.write(reinterpret_cast<const char *>(&record.key), sizeof(record.key));
+    }
+    for (const Record &record : records) {
+        char entry[2] = {(char)record.score, (char)record.column};
+        file.write(entry, 2);
+    }
+    return (bool)file;
+}
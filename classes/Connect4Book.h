@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+//
+// connect 4 opening book
+//
+// the book is a flat binary file built offline by tools/c4_book_gen.cpp:
+//   header     magic "C4BK", version, max ply, entry count (4 x uint32)
+//   keys       uint64 position keys, sorted ascending
+//   entries    one {int8 score, uint8 column} pair per key
+//
+// the file is memory mapped and binary searched in place, so opening it costs nothing
+// and lookups are served straight from the page cache.
+// positions and their mirror images share one entry, keyed on whichever key is smaller.
+// scores use the same convention as Connect4Solver
+//
+class Connect4Book
+{
+public:
+    struct Record
+    {
+        uint64_t key;
+        int8_t   score;
+        uint8_t  column;
+    };
+
+    Connect4Book();
+    ~Connect4Book();
+
+    // map a book file, returns false (and stays empty) if it's missing or malformed
+    bool        open(const std::string &path);
+    void        close();
+    bool        isOpen() const { return _count != 0; }
+    int         maxPly() const { return _maxPly; }
+    size_t      size() const { return _count; }
+
+    // myBoard is the side to move, returns false if the position isn't in the book
+    bool        lookup(uint64_t myBoard, uint64_t oppBoard, int &column, int &score) const;
+
+    // write records (in any order) to a book file
+    static bool write(const std::string &path, int maxPly, std::vector<Record> records);
+
+    // book key for a position, mirrored is set if the key belongs to the mirror image
+    static uint64_t bookKey(uint64_t myBoard, uint64_t oppBoard, bool &mirrored);
+    static uint64_t mirror(uint64_t board);
+
+    static constexpr const char *DEFAULT_FILE = "resources/connect4_book.bin";
+
+private:
+    struct Header
+    {
+        char     magic[4];
+        uint32_t version;
+        uint32_t maxPly;
+        uint32_t count;
+    };
+
+    static const uint32_t VERSION = 1;
+
+    const uint64_t *_keys;
+    const uint8_t  *_entries;
+    size_t      _count;
+    int         _maxPly;
+    MappedFile  _file;
+};
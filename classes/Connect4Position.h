@@ -0,0 +1,97 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+
+//
+// connect 4 position with a move stack
+//
+// holds both 9-stride bitboards (see Connect4Search.h), the height of every column and
+// the columns played so far, so play() and undo() are O(1) and nothing has to be backed
+// up and restored around a move. red always moves first, so the side to move is just
+// the parity of the move count.
+// header only so play/undo inline into the search
+//
+class Connect4Position
+{
+public:
+    static const int WIDTH = 7;
+    static const int HEIGHT = 6;
+    static const int STRIDE = 9;    // bits per column, the top three stay empty
+    static const int RED = 0;
+    static const int YELLOW = 1;
+
+    Connect4Position() { reset(); }
+
+    // set up from bitboards, there's no history so undo() can't go back past this position
+    Connect4Position(uint64_t redBoard, uint64_t yellowBoard)
+    {
+        _boards[RED] = redBoard;
+        _boards[YELLOW] = yellowBoard;
+        uint64_t filled = redBoard | yellowBoard;
+        for (int col = 0; col < WIDTH; col++) {
+            _heights[col] = (uint8_t)std::popcount((filled >> (col * STRIDE)) & COLUMN_MASK);
+        }
+        _moveCount = std::popcount(filled);
+        _firstMove = _moveCount;
+    }
+
+    void        reset()
+    {
+        _boards[RED] = 0;
+        _boards[YELLOW] = 0;
+        for (int col = 0; col < WIDTH; col++) {
+            _heights[col] = 0;
+        }
+        _moveCount = 0;
+        _firstMove = 0;
+    }
+
+    bool        canPlay(int column) const { return _heights[column] < HEIGHT; }
+
+    // drop a piece for the side to move, the column must have room
+    void        play(int column)
+    {
+        _boards[_moveCount & 1] |= moveBit(column);
+        _heights[column]++;
+        _moves[_moveCount++] = (uint8_t)column;
+    }
+
+    // take back the last move, returns its column
+    int         undo()
+    {
+        int column = _moves[--_moveCount];
+        _heights[column]--;
+        _boards[_moveCount & 1] ^= moveBit(column);
+        return column;
+    }
+
+    bool        canUndo() const { return _moveCount > _firstMove; }
+    int         lastMove() const { return canUndo() ? _moves[_moveCount - 1] : -1; }
+
+    // the square a piece dropped in this column would land on
+    uint64_t    moveBit(int column) const { return 1ULL << (column * STRIDE + _heights[column]); }
+
+    int         height(int column) const { return _heights[column]; }
+    int         moveCount() const { return _moveCount; }
+    bool        isFull() const { return _moveCount == WIDTH * HEIGHT; }
+    int         playerToMove() const { return _moveCount & 1; }
+
+    uint64_t    board(int player) const { return _boards[player]; }
+    uint64_t    current() const { return _boards[_moveCount & 1]; }
+    uint64_t    opponent() const { return _boards[(_moveCount & 1) ^ 1]; }
+    uint64_t    filled() const { return _boards[RED] | _boards[YELLOW]; }
+
+    // same key as Connect4Search::positionKey, from the side to move's point of view
+    uint64_t    key() const { return current() + filled() + BOTTOM_ROW; }
+
+private:
+    static const uint64_t COLUMN_MASK = 0x3f;
+    static const uint64_t BOTTOM_ROW = 0x40201008040201;
+
+    uint64_t    _boards[2];                 // red, yellow
+    uint8_t     _heights[WIDTH];
+    uint8_t     _moves[WIDTH * HEIGHT];     // column of every move, indexed by move number
+    int         _moveCount;
+    int         _firstMove;                 // undo stops here
+};
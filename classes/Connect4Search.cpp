@@ -0,0 +1,605 @@
+#include <algorithm>
+#include <bit>
+#include <thread>
+#include "Connect4Search.h"
+
+const int Connect4Search::MOVE_ORDER[7] = {3, 2, 4, 1, 5, 0, 6};
+
+// Constants for stride types (for checking n-in-a-row)
+static const uint64_t HORIZONTAL_STRIDE = 9;
+static const uint64_t VERTICAL_STRIDE = 1;
+static const uint64_t DOWNDIAG_STRIDE = HORIZONTAL_STRIDE - 1;
+static const uint64_t UPDIAG_STRIDE = HORIZONTAL_STRIDE + 1;
+static const uint64_t ALL_STRIDES[4] = {HORIZONTAL_STRIDE, VERTICAL_STRIDE, DOWNDIAG_STRIDE, UPDIAG_STRIDE};
+
+static const uint64_t COL0 = 0x3f;                  // first col (0, 1, 2, 3, 4, 5)
+static const uint64_t ROW0 = 0x40201008040201;      // first row (0, 9, 18, 27, 36, 45, 54)
+static const uint64_t ALL_SPACES = COL0 * ROW0;
+
+// rows 1, 3, 5 (counting from 1 at the bottom) and rows 2, 4, 6
+static const uint64_t ODD_ROWS = 0x15 * ROW0;
+static const uint64_t EVEN_ROWS = 0x2a * ROW0;
+
+// center control, the middle column is worth the most
+static const uint64_t CENTER_COLUMN = COL0 << (3 * 9);
+static const uint64_t INNER_COLUMNS = (COL0 << (2 * 9)) | (COL0 << (4 * 9));
+static const uint64_t OUTER_COLUMNS = (COL0 << (1 * 9)) | (COL0 << (5 * 9));
+
+// move ordering classes, history scores stay below ORDER_KILLER
+static const int ORDER_WIN = 1 << 30;
+static const int ORDER_BLOCK = 1 << 29;
+static const int ORDER_TT = 1 << 28;
+static const int ORDER_KILLER = 1 << 27;
+static const int ORDER_LOSING = -(1 << 30);     // right under an opponent's winning square
+static const int HISTORY_MAX = 1 << 20;
+static const int ORDERING_MIN_DRAFT = 3;        // closer to the leaves the fixed order is cheaper overall
+
+// wider than any score the search can return, so a full window never fails
+static const int FULL_WINDOW = Connect4Search::WINNING_SCORE + 1;
+
+// wins and losses are stored relative to the node rather than the root, so an entry means the
+// same thing whichever search reaches it and the table can be kept from one move to the next
+static const int WIN_BOUND = Connect4Search::WINNING_SCORE - 64;
+
+static int toTable(int score, int ply)
+{
+    if (score >= WIN_BOUND) return score + ply;
+    if (score <= -WIN_BOUND) return score - ply;
+    return score;
+}
+
+static int fromTable(int score, int ply)
+{
+    if (score >= WIN_BOUND) return score - ply;
+    if (score <= -WIN_BOUND) return score + ply;
+    return score;
+}
+
+Connect4Search::Connect4Search()
+{
+    _timeBudgetMs = SEARCH_TIME_MS;
+    _maxDepth = 42;
+    _threadCount = 1;
+    _evalVersion = EVAL_THREATS;
+    _dynamicOrdering = true;
+    _stop = false;
+    _cancel = nullptr;
+    _nodesSearched = 0;
+    _completedDepth = 0;
+    _bestScore = 0;
+    _cutoffs = 0;
+    _firstMoveCutoffs = 0;
+}
+
+//
+// bitboard helpers
+//
+
+// drop a piece into a column, returns false if the column is full
+bool Connect4Search::playColumn(int column, uint64_t &playerBoard, uint64_t otherBoard)
+{
+    uint64_t valid = ((playerBoard | otherBoard) + ROW0) & ALL_SPACES;  // the lowest available space of each column
+    uint64_t move = valid & (COL0 << (column * 9));
+    if (move == 0) {
+        return false;
+    }
+    playerBoard |= move;
+    return true;
+}
+
+// https://jorrid.com/posts/the-wondrous-world-of-connect-four-bit-boards/
+bool Connect4Search::isWin(uint64_t board)
+{
+    for (uint64_t stride : ALL_STRIDES) {
+        uint64_t and2 = board & (board >> stride);
+        if (and2 & (and2 >> (2 * stride))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Connect4Search::isFull(uint64_t filled)
+{
+    return filled == ALL_SPACES;
+}
+
+// unique key for a position from the side to move's point of view
+// mine + filled + bottom sets one extra bit on top of each column, so no two positions collide
+// http://blog.gamesolver.org/solving-connect-four/06-transposition-table/
+uint64_t Connect4Search::positionKey(uint64_t myBoard, uint64_t oppBoard)
+{
+    return myBoard + (myBoard | oppBoard) + ROW0;
+}
+
+// every empty square that would complete four for {board}
+// the three spare bits on top of each column keep the shifts from wrapping into the next one
+uint64_t Connect4Search::winningSpots(uint64_t board, uint64_t filled)
+{
+    // vertical, only ever the square right on top
+    uint64_t spots = (board << 1) & (board << 2) & (board << 3);
+
+    const uint64_t strides[3] = {HORIZONTAL_STRIDE, DOWNDIAG_STRIDE, UPDIAG_STRIDE};
+    for (uint64_t stride : strides) {
+        uint64_t pair = (board << stride) & (board << 2 * stride);
+        spots |= pair & (board << 3 * stride);     // xxx_
+        spots |= pair & (board >> stride);         // xx_x
+        pair = (board >> stride) & (board >> 2 * stride);
+        spots |= pair & (board << stride);         // x_xx
+        spots |= pair & (board >> 3 * stride);     // _xxx
+    }
+
+    return spots & (ALL_SPACES ^ filled);
+}
+
+int Connect4Search::countBits(uint64_t board)
+{
+    return std::popcount(board);
+}
+
+// checks for any stride of length {length}
+static bool bitRow(uint64_t board, int length)
+{
+    if (length < 2) return true;
+
+    for (uint64_t stride : ALL_STRIDES) {
+        uint64_t and2 = board & (board >> stride);
+        uint64_t inRow = and2 & (and2 >> ((length - 2) * stride));
+        if (inRow != 0) return true;
+    }
+    return false;
+}
+
+// the original evaluation, only asks whether any three or two in a row exists
+int Connect4Search::evalLegacy(uint64_t myBoard, uint64_t oppBoard)
+{
+    int score = 0;
+
+    // my advantage
+    // score center bits
+    uint64_t center = COL0 << (2 * 9);
+    score += countBits(center & myBoard) * 3;
+    center = COL0 << (3 * 9);
+    score += countBits(center & myBoard) * 5;    // true center
+    center = COL0 << (4 * 9);
+    score += countBits(center & myBoard) * 3;
+
+    if (bitRow(myBoard, 3)) {
+        score += 1000;   // 3 in a row = strong advantage
+    }
+    else if (bitRow(myBoard, 2)) {
+        score += 10;
+    }
+    else {
+        score -= 100;   // punish isolated pieces
+    }
+
+    // opp advantage
+    if (bitRow(oppBoard, 3)) {
+        score -= 2000;
+    }
+    else if (bitRow(oppBoard, 2)) {
+        score -= 100;
+    }
+    else {
+        score += 10;
+    }
+
+    return score;
+}
+
+//
+// threat based evaluation
+//
+// a threat is an empty square that would complete four. the first player (red) wants
+// threats on odd rows and the second player on even rows: with the board filling up
+// column by column that's where zugzwang hands each side its win at the end of the game
+// https://tromp.github.io/c4/c4.html (Allis, "A Knowledge-based Approach of Connect-Four")
+//
+int Connect4Search::evalThreats(uint64_t myBoard, uint64_t oppBoard)
+{
+    uint64_t filled = myBoard | oppBoard;
+    uint64_t playable = (filled + ROW0) & ALL_SPACES;
+    uint64_t myThreats = winningSpots(myBoard, filled);
+    uint64_t oppThreats = winningSpots(oppBoard, filled);
+
+    // decided one move from now
+    if (myThreats & playable) {
+        return EVAL_LIMIT;
+    }
+    uint64_t forced = oppThreats & playable;
+    if (forced & (forced - 1)) {
+        return -EVAL_LIMIT;
+    }
+
+    // with an even number of pieces down the side to move went first
+    bool moverIsFirst = (std::popcount(filled) & 1) == 0;
+    uint64_t myRows = moverIsFirst ? ODD_ROWS : EVEN_ROWS;
+    uint64_t oppRows = moverIsFirst ? EVEN_ROWS : ODD_ROWS;
+
+    // a threat sitting right on top of an opponent threat can never be cashed in
+    uint64_t myLive = myThreats & ~(oppThreats << 1);
+    uint64_t oppLive = oppThreats & ~(myThreats << 1);
+
+    int score = 0;
+    score += 8 * (std::popcount(myLive) - std::popcount(oppLive));
+    score += 12 * (std::popcount(myLive & myRows) - std::popcount(oppLive & oppRows));
+
+    score += 3 * (std::popcount(myBoard & CENTER_COLUMN) - std::popcount(oppBoard & CENTER_COLUMN));
+    score += 2 * (std::popcount(myBoard & INNER_COLUMNS) - std::popcount(oppBoard & INNER_COLUMNS));
+    score += std::popcount(myBoard & OUTER_COLUMNS) - std::popcount(oppBoard & OUTER_COLUMNS);
+
+    return std::clamp(score, 1 - EVAL_LIMIT, EVAL_LIMIT - 1);
+}
+
+//
+// search
+//
+
+int Connect4Search::findBestMove(const Connect4Position &position, const std::atomic<bool> *cancel, int timeBudgetMs)
+{
+    // the table is kept from the last move, older entries just get replaced first
+    _tt.newSearch();
+    _stop = false;
+    _cancel = cancel;
+    _deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeBudgetMs > 0 ? timeBudgetMs : _timeBudgetMs);
+
+    int emptySpaces = Connect4Position::WIDTH * Connect4Position::HEIGHT - position.moveCount();
+
+    std::vector<ThreadData> threads(_threadCount);
+    for (int i = 0; i < _threadCount; i++) {
+        ThreadData &td = threads[i];
+        td.id = i;
+        td.position = position;
+        td.nodes = 0;
+        td.searchDepth = 0;
+        td.completedDepth = 0;
+        td.bestColumn = -1;
+        td.bestScore = 0;
+        td.canAbort = false;
+        td.principalVariation.clear();
+        td.pvLength[0] = 0;
+        td.rootPvLength = 0;
+        std::fill(&td.killers[0][0], &td.killers[0][0] + 43 * 2, -1);
+        std::fill(&td.history[0][0], &td.history[0][0] + 2 * 64, 0);
+        td.cutoffs = 0;
+        td.firstMoveCutoffs = 0;
+    }
+
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < _threadCount; i++) {
+        helpers.emplace_back([this, &threads, i, emptySpaces]() {
+            iterativeDeepening(threads[i], emptySpaces);
+        });
+    }
+
+    // the calling thread is the main search thread, when it's done everybody stops
+    iterativeDeepening(threads[0], emptySpaces);
+    _stop = true;
+    for (std::thread &helper : helpers) {
+        helper.join();
+    }
+
+    // take the deepest finished result, the main thread wins ties
+    ThreadData *best = &threads[0];
+    _nodesSearched = 0;
+    _cutoffs = 0;
+    _firstMoveCutoffs = 0;
+    for (ThreadData &td : threads) {
+        _nodesSearched += td.nodes;
+        _cutoffs += td.cutoffs;
+        _firstMoveCutoffs += td.firstMoveCutoffs;
+        if (td.bestColumn >= 0 && td.completedDepth > best->completedDepth) {
+            best = &td;
+        }
+    }
+    _completedDepth = best->completedDepth;
+    _bestScore = best->bestScore;
+    _principalVariation = best->principalVariation;
+    return best->bestColumn;
+}
+
+//
+// iterative deepening: search one ply deeper each pass until the time budget runs out
+// the best move of each pass is tried first on the next one, and an unfinished pass is thrown away
+//
+void Connect4Search::iterativeDeepening(ThreadData &td, int emptySpaces)
+{
+    int rootOrder[7];
+    std::copy(MOVE_ORDER, MOVE_ORDER + 7, rootOrder);
+
+    // helpers try the root moves in a different order, and every other one starts a ply deeper
+    std::rotate(rootOrder, rootOrder + (td.id % 7), rootOrder + 7);
+    int firstDepth = 1 + (td.id & 1);
+    int lastDepth = std::min(emptySpaces, _maxDepth);
+
+    for (int depth = firstDepth; depth <= lastDepth; depth++) {
+        td.searchDepth = depth - 1;
+
+        // aspiration window around the last score, a win or loss is exact so it gets the full window
+        int alpha = -FULL_WINDOW;
+        int beta = FULL_WINDOW;
+        if (td.completedDepth > 0 && std::abs(td.bestScore) <= EVAL_LIMIT) {
+            alpha = td.bestScore - ASPIRATION_WINDOW;
+            beta = td.bestScore + ASPIRATION_WINDOW;
+        }
+
+        // widen whichever side the score fell out of until it lands inside
+        int score = 0;
+        int column = -1;
+        for (int delta = ASPIRATION_WINDOW * 4; ; delta *= 4) {
+            column = searchRoot(td, rootOrder, alpha, beta, score);
+            if (_stop.load(std::memory_order_relaxed) || column < 0) {
+                break;
+            }
+            if (score <= alpha && alpha > -FULL_WINDOW) {
+                alpha = std::max(score - delta, -FULL_WINDOW);
+            } else if (score >= beta && beta < FULL_WINDOW) {
+                beta = std::min(score + delta, FULL_WINDOW);
+            } else {
+                break;
+            }
+        }
+        if (_stop.load(std::memory_order_relaxed) || column < 0) {
+            break;
+        }
+
+        td.bestColumn = column;
+        td.bestScore = score;
+        td.completedDepth = depth;
+        td.canAbort = true; // we have a move to fall back on now
+        td.principalVariation.assign(td.rootPv, td.rootPv + td.rootPvLength);
+
+        // move this pass's best move to the front for the next pass
+        int *found = std::find(rootOrder, rootOrder + 7, column);
+        std::rotate(rootOrder, found, found + 1);
+
+        if (td.id == 0 && std::chrono::steady_clock::now() >= _deadline) {
+            break;
+        }
+    }
+}
+
+//
+// search every root move to the thread's current depth inside (alpha, beta), returns the
+// best column. a score at or below alpha is only an upper bound and one at or above beta
+// only a lower bound, and the caller widens the window and searches again
+//
+int Connect4Search::searchRoot(ThreadData &td, const int *rootOrder, int alpha, int beta, int &bestScore)
+{
+    int bestMove = -FULL_WINDOW - 1;
+    int bestColumn = -1;
+    bool first = true;
+
+    for (int i = 0; i < 7; i++) {
+        int col = rootOrder[i];
+        if (!td.position.canPlay(col)) { // no available spaces in this column, move on
+            continue;
+        }
+
+        // the first move gets the whole window, the rest only have to show they're no better
+        td.position.play(col);
+        int score;
+        if (first) {
+            score = -negamax(td, 0, -beta, -alpha);
+        } else {
+            score = -negamax(td, 0, -alpha - 1, -alpha);
+            if (score > alpha && score < beta && !_stop.load(std::memory_order_relaxed)) {
+                score = -negamax(td, 0, -beta, -alpha);
+            }
+        }
+        td.position.undo();
+        first = false;
+
+        if (_stop.load(std::memory_order_relaxed)) {
+            return -1;
+        }
+
+        if (score > bestMove) {
+            bestMove = score;
+            bestColumn = col;
+            td.rootPv[0] = col;
+            std::copy(td.pv[0], td.pv[0] + td.pvLength[0], td.rootPv + 1);
+            td.rootPvLength = td.pvLength[0] + 1;
+        }
+        alpha = std::max(alpha, score);
+        if (alpha >= beta) {
+            break;  // fails high, the caller searches again with a wider window
+        }
+        if (alpha >= WINNING_SCORE) {
+            break;  // winning on the spot, nothing can beat it
+        }
+    }
+
+    bestScore = bestMove;
+    return bestColumn;
+}
+
+// only the main thread watches the clock and the cancel flag, helpers just follow _stop
+bool Connect4Search::shouldStop(ThreadData &td)
+{
+    if (_stop.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    // poll the clock every few thousand nodes, not on every one
+    if ((++td.nodes & 4095) == 0 && td.id == 0) {
+        if ((_cancel && _cancel->load()) ||
+            (td.canAbort && std::chrono::steady_clock::now() >= _deadline)) {
+            _stop = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+// scores are from the point of view of the side to move in td.position
+int Connect4Search::negamax(ThreadData &td, int depth, int alpha, int beta)
+{
+    Connect4Position &position = td.position;
+
+    td.pvLength[depth] = 0;
+    if (shouldStop(td)) return 0;  // out of time, this result is meaningless
+
+    // check terminals, only the side that just moved can have won
+    // a quicker win scores higher, by one point a ply
+    if (isWin(position.opponent())) return -(WINNING_SCORE - depth);
+    if (depth >= td.searchDepth) {
+        return (_evalVersion == EVAL_THREATS) ? evalThreats(position.current(), position.opponent())
+                                              : evalLegacy(position.current(), position.opponent());
+    }
+
+    // check for draw
+    if (position.isFull()) {
+        return 0;
+    }
+
+    // transposition table lookup. nodes inside a full window keep searching whatever the
+    // table says, so the principal variation comes out whole
+    int alphaOrig = alpha;
+    bool pvNode = beta - alpha > 1;
+    int draft = td.searchDepth - depth;
+    int ttMove = -1;
+    uint64_t key = position.key();
+    TranspositionTable::Entry entry;
+    if (_tt.probe(key, entry)) {
+        ttMove = entry.move;
+        if (!pvNode && entry.depth >= draft) {
+            int score = fromTable(entry.score, depth);
+            if (entry.bound == TranspositionTable::BOUND_EXACT) return score;
+            if (entry.bound == TranspositionTable::BOUND_LOWER) alpha = std::max(alpha, score);
+            if (entry.bound == TranspositionTable::BOUND_UPPER) beta = std::min(beta, score);
+            if (alpha >= beta) return score;
+        }
+    }
+
+    int bestValue = -WINNING_SCORE * 100;
+    int bestColumn = -1;
+
+    int moves[7];
+    int count = orderMoves(td, depth, ttMove, moves);
+    for (int i = 0; i < count; i++) {
+        int col = moves[i];
+        position.play(col);
+        int newValue;
+        if (i == 0) {
+            newValue = -negamax(td, depth + 1, -beta, -alpha);
+        } else {
+            // principal variation search: a null window proves the move is no better, and
+            // only a move that beats alpha gets searched again with the full window
+            newValue = -negamax(td, depth + 1, -alpha - 1, -alpha);
+            if (newValue > alpha && newValue < beta && !_stop.load(std::memory_order_relaxed)) {
+                newValue = -negamax(td, depth + 1, -beta, -alpha);
+            }
+        }
+        position.undo();
+
+        if (_stop.load(std::memory_order_relaxed)) return 0;
+
+        if (newValue > bestValue) {
+            bestValue = newValue;
+            bestColumn = col;
+            if (pvNode && newValue > alpha) {
+                td.pv[depth][0] = col;
+                std::copy(td.pv[depth + 1], td.pv[depth + 1] + td.pvLength[depth + 1], td.pv[depth] + 1);
+                td.pvLength[depth] = td.pvLength[depth + 1] + 1;
+            }
+        }
+        alpha = std::max(alpha, newValue);
+
+        if (alpha >= beta) {    // prune
+            td.cutoffs++;
+            if (i == 0) td.firstMoveCutoffs++;
+            updateOrdering(td, depth, col, draft);
+            break;
+        }
+    }
+
+    TranspositionTable::Bound bound = TranspositionTable::BOUND_EXACT;
+    if (bestValue <= alphaOrig) bound = TranspositionTable::BOUND_UPPER;
+    else if (bestValue >= beta) bound = TranspositionTable::BOUND_LOWER;
+    _tt.store(key, toTable(bestValue, depth), bestColumn, draft, bound);
+
+    return bestValue;
+}
+
+//
+// order the legal moves at this node, best first, returns how many there are
+//
+// wins come first, then blocks of the opponent's immediate wins, then the table's move,
+// then this ply's killers, then the history table with the number of new threats a move
+// makes as the tie break. moves right under an opponent's winning square go last.
+// ties keep the center-out order. near the leaves scoring the moves costs more than it
+// saves, so those nodes just put the table's move in front of the center-out order
+//
+int Connect4Search::orderMoves(ThreadData &td, int depth, int ttMove, int *moves)
+{
+    const Connect4Position &position = td.position;
+    int count = 0;
+
+    if (!_dynamicOrdering || td.searchDepth - depth < ORDERING_MIN_DRAFT) {
+        if (ttMove >= 0) {
+            moves[count++] = ttMove;
+        }
+        for (int col : MOVE_ORDER) {
+            if (col != ttMove && position.canPlay(col)) {
+                moves[count++] = col;
+            }
+        }
+        return count;
+    }
+
+    uint64_t filled = position.filled();
+    uint64_t myBoard = position.current();
+    uint64_t myThreats = winningSpots(myBoard, filled);
+    uint64_t oppThreats = winningSpots(position.opponent(), filled);
+    const int *history = td.history[position.playerToMove()];
+
+    int scores[7];
+    for (int col : MOVE_ORDER) {
+        if (!position.canPlay(col)) {
+            continue;
+        }
+
+        uint64_t move = position.moveBit(col);
+        int score;
+        if (move & myThreats) score = ORDER_WIN;
+        else if (move & oppThreats) score = ORDER_BLOCK;
+        else if (col == ttMove) score = ORDER_TT;
+        else if (col == td.killers[depth][0]) score = ORDER_KILLER + 1;
+        else if (col == td.killers[depth][1]) score = ORDER_KILLER;
+        else if ((move << 1) & oppThreats) score = ORDER_LOSING;
+        else {
+            int newThreats = std::popcount(winningSpots(myBoard | move, filled | move) & ~myThreats);
+            score = history[std::countr_zero(move)] * 8 + newThreats;
+        }
+
+        // insertion sort, strictly better moves jump ahead so ties stay in center-out order
+        int j = count++;
+        for (; j > 0 && scores[j - 1] < score; j--) {
+            moves[j] = moves[j - 1];
+            scores[j] = scores[j - 1];
+        }
+        moves[j] = col;
+        scores[j] = score;
+    }
+    return count;
+}
+
+// a move caused a cutoff: remember it as a killer for this ply and bump its history
+void Connect4Search::updateOrdering(ThreadData &td, int depth, int column, int draft)
+{
+    if (td.killers[depth][0] != column) {
+        td.killers[depth][1] = td.killers[depth][0];
+        td.killers[depth][0] = column;
+    }
+
+    // deeper cutoffs count for more, halve everything once the counts get big
+    int *history = td.history[td.position.playerToMove()];
+    int &entry = history[std::countr_zero(td.position.moveBit(column))];
+    entry += draft * draft;
+    if (entry > HISTORY_MAX) {
+        for (int square = 0; square < 64; square++) {
+            history[square] /= 2;
+        }
+    }
+}
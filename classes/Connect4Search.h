@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include "Connect4Position.h"
+#include "TranspositionTable.h"
+
+//
+// connect 4 search engine, independent of the gui so it can run on worker threads
+//
+// boards use a 9-stride layout: column c owns bits 9c .. 9c+5 with bit 9c at the
+// bottom, the top three bits of each column stay empty
+//
+// with more than one thread this is a lazy SMP search: every thread runs its own
+// iterative deepening on the same root, and they only talk through the shared
+// transposition table. helpers start at different depths and root move orders so
+// they fill the table with work the main thread can reuse
+//
+// every node is a principal variation search: the first move gets the full window and
+// the rest a null window that only proves they're no better, with a full re-search when
+// that fails. each pass of iterative deepening starts from a narrow aspiration window
+// around the score of the pass before and widens it when the score falls outside
+//
+// a win scores WINNING_SCORE less the plies to it, kept relative to the node in the table, so
+// the table carries over from one move to the next and a search after pondering starts warm
+//
+class Connect4Search
+{
+public:
+    // leaf evaluators, the legacy one is kept around for benchmarking
+    enum EvalVersion
+    {
+        EVAL_LEGACY,    // any three / two in a row, from the original Connect4::eval
+        EVAL_THREATS    // threat squares with odd/even parity and center control
+    };
+
+    Connect4Search();
+
+    // pick a column for the side to move, returns -1 if there's no legal move
+    // {timeBudgetMs} overrides setTimeBudget() for this search only, 0 keeps it
+    int         findBestMove(const Connect4Position &position, const std::atomic<bool> *cancel = nullptr, int timeBudgetMs = 0);
+
+    // settings
+    void        setTimeBudget(int milliseconds) { _timeBudgetMs = milliseconds; }
+    int         getTimeBudget() const { return _timeBudgetMs; }
+    void        setMaxDepth(int depth) { _maxDepth = depth; }
+    void        setThreads(int threads) { _threadCount = threads < 1 ? 1 : threads; }
+    void        setTranspositionTableSize(size_t megabytes) { _tt.resize(megabytes); }
+    // wipe the table, so a search doesn't depend on the ones before it
+    void        clearTranspositionTable() { _tt.clear(); }
+    void        setEvalVersion(EvalVersion version) { _evalVersion = version; }
+    // false falls back to the fixed center-out order, for benchmarking
+    void        setDynamicOrdering(bool dynamic) { _dynamicOrdering = dynamic; }
+
+    // statistics from the last search
+    uint64_t    getNodesSearched() const { return _nodesSearched; }
+    int         getCompletedDepth() const { return _completedDepth; }
+    int         getBestScore() const { return _bestScore; }
+    // the line the search expects, starting with its move, as columns
+    const std::vector<int> &getPrincipalVariation() const { return _principalVariation; }
+    uint64_t    getCutoffs() const { return _cutoffs; }
+    uint64_t    getFirstMoveCutoffs() const { return _firstMoveCutoffs; }
+
+    // bitboard helpers
+    static bool     playColumn(int column, uint64_t &playerBoard, uint64_t otherBoard);
+    static bool     isWin(uint64_t board);
+    static bool     isFull(uint64_t filled);
+    static uint64_t positionKey(uint64_t myBoard, uint64_t oppBoard);
+    static uint64_t winningSpots(uint64_t board, uint64_t filled);
+    static int      countBits(uint64_t board);
+
+    // static evaluation from the side to move's point of view
+    static int      evalLegacy(uint64_t myBoard, uint64_t oppBoard);
+    static int      evalThreats(uint64_t myBoard, uint64_t oppBoard);
+
+    static const int WINNING_SCORE = 10000;
+    static const int SEARCH_TIME_MS = 500;  // default time budget for one AI move
+    static const int EVAL_LIMIT = 200;      // evalThreats stays inside this, below any win score
+    static const int ASPIRATION_WINDOW = 16;    // each side of the last pass's score
+
+private:
+    // everything one search thread touches while it runs
+    struct ThreadData
+    {
+        int         id;
+        Connect4Position position;  // played forward and back as the thread searches
+        uint64_t    nodes;
+        int         searchDepth;    // depth of the current iterative deepening pass
+        int         completedDepth;
+        int         bestColumn;
+        int         bestScore;
+        bool        canAbort;       // only abort once one pass has finished
+        std::vector<int> principalVariation;    // of the last finished pass
+
+        // the best line below each ply of the running pass, pv[depth][0] is the move at depth
+        int         pv[43][43];
+        int         pvLength[43];
+        int         rootPv[43];
+        int         rootPvLength;
+
+        // move ordering, kept per thread so nothing is shared but the table
+        int         killers[43][2];     // last two quiet moves that caused a cutoff at each ply
+        int         history[2][64];     // cutoff counts by side to move and square
+        uint64_t    cutoffs;
+        uint64_t    firstMoveCutoffs;
+    };
+
+    void        iterativeDeepening(ThreadData &td, int emptySpaces);
+    int         searchRoot(ThreadData &td, const int *rootOrder, int alpha, int beta, int &bestScore);
+    int         negamax(ThreadData &td, int depth, int alpha, int beta);
+    int         orderMoves(ThreadData &td, int depth, int ttMove, int *moves);
+    void        updateOrdering(ThreadData &td, int depth, int column, int draft);
+    bool        shouldStop(ThreadData &td);
+
+    TranspositionTable _tt;
+    int         _timeBudgetMs;
+    int         _maxDepth;
+    int         _threadCount;
+    EvalVersion _evalVersion;
+    bool        _dynamicOrdering;
+
+    // shared between the threads of one search
+    std::atomic<bool> _stop;
+    const std::atomic<bool> *_cancel;
+    std::chrono::steady_clock::time_point _deadline;
+
+    uint64_t    _nodesSearched;
+    int         _completedDepth;
+    int         _bestScore;
+    std::vector<int> _principalVariation;
+    uint64_t    _cutoffs;
+    uint64_t    _firstMoveCutoffs;
+
+    static const int MOVE_ORDER[7];
+};
@@ -0,0 +1,243 @@
+#include <bit>
+#include "Connect4Solver.h"
+#include "Connect4Search.h"
+
+const int Connect4Solver::MOVE_ORDER[7] = {3, 2, 4, 1, 5, 0, 6};
+
+static const int STRIDE = 9;                        // bits per column
+static const uint64_t COL0 = 0x3f;                  // first col (0, 1, 2, 3, 4, 5)
+static const uint64_t ROW0 = 0x40201008040201;      // first row (0, 9, 18, 27, 36, 45, 54)
+static const uint64_t ALL_SPACES = COL0 * ROW0;
+
+Connect4Solver::Connect4Solver() : _tt(TT_MEGABYTES)
+{
+    _nodesSearched = 0;
+    _timeBudgetMs = 1000;
+    _aborted = false;
+    _cancel = nullptr;
+}
+
+//
+// bitboard helpers
+//
+
+// the lowest open square of each column
+uint64_t Connect4Solver::possible(const Position &pos)
+{
+    return (pos.mask + ROW0) & ALL_SPACES;
+}
+
+bool Connect4Solver::canWinNext(const Position &pos)
+{
+    return Connect4Search::winningSpots(pos.current, pos.mask) & possible(pos);
+}
+
+//
+// moves that don't hand the opponent an immediate win
+// if the opponent has two threats we can't stop, there are none
+//
+uint64_t Connect4Solver::possibleNonLosingMoves(const Position &pos)
+{
+    uint64_t possibleMask = possible(pos);
+    uint64_t opponentWin = Connect4Search::winningSpots(pos.current ^ pos.mask, pos.mask);
+    uint64_t forcedMoves = possibleMask & opponentWin;
+    if (forcedMoves) {
+        if (forcedMoves & (forcedMoves - 1)) {
+            return 0;   // two forced moves, can't block both
+        }
+        possibleMask = forcedMoves;
+    }
+    return possibleMask & ~(opponentWin >> 1);  // don't play right under an opponent's winning square
+}
+
+// how many winning squares this move would leave us with, used for move ordering
+int Connect4Solver::moveScore(const Position &pos, uint64_t move)
+{
+    return std::popcount(Connect4Search::winningSpots(pos.current | move, pos.mask));
+}
+
+// after the move, current is the other side's pieces
+void Connect4Solver::play(Position &pos, uint64_t move)
+{
+    pos.current ^= pos.mask;
+    pos.mask |= move;
+    pos.moves++;
+}
+
+int Connect4Solver::distanceToEnd(int score, int moveCount)
+{
+    if (score == 0) {
+        return 42 - moveCount;
+    }
+    // the winner plays 22 - |score| pieces, the last of them lands on an odd distance for us or an even one for them
+    int distance = 43 - 2 * (score > 0 ? score : -score) - moveCount;
+    if ((distance & 1) != (score > 0 ? 1 : 0)) {
+        distance++;
+    }
+    return distance;
+}
+
+//
+// search
+//
+
+bool Connect4Solver::timeUp()
+{
+    if (_aborted) {
+        return true;
+    }
+    if ((++_nodesSearched & 4095) == 0) {
+        if ((_cancel && _cancel->load()) || std::chrono::steady_clock::now() >= _deadline) {
+            _aborted = true;
+        }
+    }
+    return _aborted;
+}
+
+//
+// null-window friendly negamax, assumes the side to move can't win right away
+// returns a bound: <= alpha means the real score is at most that, >= beta at least that
+//
+int Connect4Solver::negamax(const Position &pos, int alpha, int beta)
+{
+    if (timeUp()) return 0;
+
+    uint64_t next = possibleNonLosingMoves(pos);
+    if (next == 0) {
+        return -(42 - pos.moves) / 2;   // whatever we do the opponent wins next move
+    }
+    if (pos.moves >= 40) {
+        return 0;                       // neither side can win with the last two pieces
+    }
+
+    // we can't win this move, so the best we can do is win with our next piece
+    int min = -(40 - pos.moves) / 2;
+    int max = (41 - pos.moves) / 2;
+
+    uint64_t key = pos.current + pos.mask + ROW0;
+    TranspositionTable::Entry entry;
+    if (_tt.probe(key, entry)) {
+        if (entry.bound == TranspositionTable::BOUND_UPPER && entry.score < max) max = entry.score;
+        if (entry.bound == TranspositionTable::BOUND_LOWER && entry.score > min) min = entry.score;
+    }
+
+    if (alpha < min) {
+        alpha = min;
+        if (alpha >= beta) return alpha;
+    }
+    if (beta > max) {
+        beta = max;
+        if (alpha >= beta) return beta;
+    }
+
+    // order by how many threats each move makes, center first on ties
+    uint64_t moves[7];
+    int scores[7];
+    int count = 0;
+    for (int i = 0; i < 7; i++) {
+        uint64_t move = next & (COL0 << (MOVE_ORDER[i] * STRIDE));
+        if (!move) continue;
+        int score = moveScore(pos, move);
+        int j = count++;
+        for (; j > 0 && scores[j - 1] < score; j--) {
+            moves[j] = moves[j - 1];
+            scores[j] = scores[j - 1];
+        }
+        moves[j] = move;
+        scores[j] = score;
+    }
+
+    int draft = 42 - pos.moves;
+    for (int i = 0; i < count; i++) {
+        Position child = pos;
+        play(child, moves[i]);
+        int score = -negamax(child, -beta, -alpha);
+        if (_aborted) return 0;
+
+        if (score >= beta) {
+            _tt.store(key, score, -1, draft, TranspositionTable::BOUND_LOWER);
+            return score;
+        }
+        if (score > alpha) alpha = score;
+    }
+
+    _tt.store(key, alpha, -1, draft, TranspositionTable::BOUND_UPPER);
+    return alpha;
+}
+
+// narrow [min, max] down to the exact score with null-window searches
+int Connect4Solver::search(const Position &pos, int min, int max)
+{
+    while (min < max) {
+        int med = min + (max - min) / 2;
+        // lean towards zero first, those searches are the cheapest
+        if (med <= 0 && min / 2 < med) med = min / 2;
+        else if (med >= 0 && max / 2 > med) med = max / 2;
+
+        int r = negamax(pos, med, med + 1);
+        if (_aborted) return UNKNOWN;
+
+        if (r <= med) max = r;
+        else min = r;
+    }
+    return min;
+}
+
+int Connect4Solver::solve(uint64_t myBoard, uint64_t oppBoard, bool weak)
+{
+    Position pos = {myBoard, myBoard | oppBoard, std::popcount(myBoard | oppBoard)};
+
+    _nodesSearched = 0;
+    _aborted = false;
+    _deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(_timeBudgetMs);
+    _tt.newSearch();
+
+    if (canWinNext(pos)) {
+        return weak ? 1 : (43 - pos.moves) / 2;
+    }
+
+    int min = weak ? -1 : -(42 - pos.moves) / 2;
+    int max = weak ? 1 : (43 - pos.moves) / 2;
+    int score = search(pos, min, max);
+
+    if (weak && score != UNKNOWN) {
+        score = (score > 0) - (score < 0);
+    }
+    return score;
+}
+
+int Connect4Solver::bestMove(uint64_t myBoard, uint64_t oppBoard, int &score)
+{
+    Position pos = {myBoard, myBoard | oppBoard, std::popcount(myBoard | oppBoard)};
+
+    // take a win if there is one
+    uint64_t wins = Connect4Search::winningSpots(pos.current, pos.mask) & possible(pos);
+    if (wins) {
+        score = (43 - pos.moves) / 2;
+        return std::countr_zero(wins) / STRIDE;
+    }
+
+    score = solve(myBoard, oppBoard);
+    if (score == UNKNOWN) {
+        return -1;
+    }
+
+    // every move loses straight away, just play something legal
+    uint64_t next = possibleNonLosingMoves(pos);
+    if (next == 0) {
+        return std::countr_zero(possible(pos)) / STRIDE;
+    }
+
+    // the first move that keeps the score, the child has to score no better than -score for the opponent
+    for (int col : MOVE_ORDER) {
+        uint64_t move = next & (COL0 << (col * STRIDE));
+        if (!move) continue;
+
+        Position child = pos;
+        play(child, move);
+        int r = negamax(child, -score, -score + 1);
+        if (_aborted) return -1;
+        if (r <= -score) return col;
+    }
+    return -1;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include "TranspositionTable.h"
+
+//
+// exact connect 4 solver
+//
+// works on the same 9-stride bitboards as Connect4Search, and follows the approach from
+// http://blog.gamesolver.org/ : null-window searches narrowing in on the score,
+// a transposition table of bounds, and pruning of moves that lose on the spot
+//
+// scores are from the point of view of the side to move:
+//   0       draw
+//   s > 0   win, and we finish with (22 - s) of our own pieces on the board
+//   s < 0   loss, and the opponent finishes with (22 - |s|) of theirs
+// so a bigger score is a faster win or a slower loss
+//
+class Connect4Solver
+{
+public:
+    Connect4Solver();
+
+    // myBoard is the side to move, oppBoard the other side
+    // weak only finds win/draw/loss and returns 1, 0 or -1
+    // returns UNKNOWN if the time budget or cancel flag stopped the search
+    int         solve(uint64_t myBoard, uint64_t oppBoard, bool weak = false);
+
+    // best column for the side to move (shortest win, longest loss), -1 if it ran out of time
+    int         bestMove(uint64_t myBoard, uint64_t oppBoard, int &score);
+
+    // settings
+    void        setTimeBudget(int milliseconds) { _timeBudgetMs = milliseconds; }
+    void        setCancelFlag(const std::atomic<bool> *cancel) { _cancel = cancel; }
+    void        setTranspositionTableSize(size_t megabytes) { _tt.resize(megabytes); }
+    void        reset() { _tt.clear(); }
+
+    uint64_t    getNodesSearched() const { return _nodesSearched; }
+
+    // how many more pieces get played before the game is decided (0 for a draw)
+    static int  distanceToEnd(int score, int moveCount);
+
+    static const int UNKNOWN = -1000;
+    static const int TT_MEGABYTES = 64;
+
+private:
+    // position from the side to move's point of view
+    struct Position
+    {
+        uint64_t current;   // side to move
+        uint64_t mask;      // every piece on the board
+        int      moves;
+    };
+
+    int         negamax(const Position &pos, int alpha, int beta);
+    int         search(const Position &pos, int min, int max);
+    bool        timeUp();
+
+    static bool     canWinNext(const Position &pos);
+    static uint64_t possible(const Position &pos);
+    static uint64_t possibleNonLosingMoves(const Position &pos);
+    static int      moveScore(const Position &pos, uint64_t move);
+    static void     play(Position &pos, uint64_t move);
+
+    TranspositionTable _tt;
+    uint64_t    _nodesSearched;
+    int         _timeBudgetMs;
+    bool        _aborted;
+    const std::atomic<bool> *_cancel;
+    std::chrono::steady_clock::time_point _deadline;
+
+    static const int MOVE_ORDER[7];
+};
@@ -3,6 +3,7 @@
 #include "BitHolder.h"
 #include "Turn.h"
 #include "../Application.h"
+#include <cmath>
 
 Game::Game()
 {
@@ -16,6 +17,11 @@ Game::Game()
 	_gameOptions.score = 0;
 	_gameOptions.AIDepthSearches = 0;
 	_gameOptions.AIvsAI = false;
+	_aiCancel = false;
+	_pondering = false;
+	_ponderStop = false;
+	_aiPondered = false;
+	_ponderBudgetMs = 0;
 
 	_table = nullptr;
 	_winner = nullptr;
@@ -242,8 +248,80 @@ bool Game::gameHasAI()
 	return false;
 }
 
+//
+// default AI driver: start a search if none is running, otherwise check if the worker is done
+// never blocks, so the render loop keeps going while the AI thinks
+//
 void Game::updateAI()
 {
+	if (!_aiMove.valid())
+	{
+		_aiCancel = false;
+		if (_ponderMove.valid() && ponderHit())
+		{
+			// the human played the expected reply, and the search has been on the position since they started thinking
+			_aiMove = std::move(_ponderMove);
+			_aiPondered = true;
+			_ponderDeadline = _ponderStart + std::chrono::milliseconds(_ponderBudgetMs);
+			return;
+		}
+		stopPondering();
+		_aiMove = startAISearch();
+		return;
+	}
+	if (_aiPondered && std::chrono::steady_clock::now() >= _ponderDeadline)
+	{
+		_ponderStop = true;
+	}
+	if (_aiMove.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+	{
+		int move = _aiMove.get();
+		_aiPondered = false;
+		if (!_aiCancel)
+		{
+			applyAIMove(move);
+		}
+	}
+}
+
+void Game::cancelAISearch()
+{
+	_aiCancel = true;
+	_ponderStop = true;
+	if (_aiMove.valid())
+	{
+		_aiMove.wait();
+		_aiMove = std::future<int>();
+	}
+	_aiPondered = false;
+	stopPondering();
+}
+
+//
+// pondering driver: start a search on the human's turn if pondering is on and none is running yet
+// never blocks, and the search keeps going until the human moves and updateAI() deals with it
+//
+void Game::updatePonder()
+{
+	if (!_pondering || !_gameOptions.AIPlayer || _ponderMove.valid() || _aiMove.valid())
+	{
+		return;
+	}
+	_ponderStop = false;
+	_ponderStart = std::chrono::steady_clock::now();
+	// the normal move time, read here while no search is running
+	_ponderBudgetMs = aiTimeBudget();
+	_ponderMove = startPonder();
+}
+
+void Game::stopPondering()
+{
+	_ponderStop = true;
+	if (_ponderMove.valid())
+	{
+		_ponderMove.wait();
+		_ponderMove = std::future<int>();
+	}
 }
 
 void Game::mouseDown(ImVec2 &location, Entity *entity)
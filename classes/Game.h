@@ -95,6 +95,34 @@ public:
 	virtual void stopGame() = 0;
 	virtual bool gameHasAI();
 	virtual void updateAI();
+
+	// asynchronous AI
+	// startAISearch() runs on the main thread, snapshots the position and launches the search on a worker thread.
+	// the default updateAI() polls that future every frame and hands the result to applyAIMove() on the main thread.
+	// games that return an invalid future (the default) don't search asynchronously
+	virtual std::future<int> startAISearch() { return std::future<int>(); }
+	virtual void applyAIMove(int move) {}
+	// stop any search in flight and wait for the worker to finish, call before tearing down the board
+	void cancelAISearch();
+	bool isAIThinking() const { return _aiMove.valid(); }
+	// the line of play the AI expected when it made its last move, empty if it has nothing to show
+	virtual std::string aiExpectedLine() { return ""; }
+	// play with monte carlo tree search instead of the game's own search, for games that have both
+	virtual void setMonteCarloAI(bool monteCarlo) {}
+
+	// pondering: keep searching on the human's turn as well
+	// updatePonder() is polled every frame of the human's turn, and calls startPonder() to launch a search
+	// of the position the AI expects to face next, with no time limit (PONDER_TIME_MS passed to the search,
+	// the engine's settings are left alone) and _ponderStop as its cancel flag.
+	// once the human has moved, ponderHit() says whether they played the reply it expected. if they did
+	// that search becomes the AI's move, given aiTimeBudget() counted from when it started, and if they
+	// didn't it's stopped and startAISearch() runs as usual, on whatever the ponder search left behind
+	void setPondering(bool ponder) { _pondering = ponder; }
+	bool isPondering() const { return _ponderMove.valid(); }
+	void updatePonder();
+	virtual std::future<int> startPonder() { return std::future<int>(); }
+	virtual bool ponderHit() { return false; }
+	virtual int aiTimeBudget() { return 0; }
 	virtual void pieceTaken(Bit *bit){};
 
 	virtual std::string initialStateString() = 0;
@@ -151,4 +179,19 @@ protected:
 	BitHolder *_dropTarget;
 	BitHolder *_oldHolder;
 	bool _dragMoved;
+
+	// asynchronous AI state
+	std::future<int> _aiMove;
+	std::atomic<bool> _aiCancel;
+
+	// pondering state
+	static const int PONDER_TIME_MS = 24 * 60 * 60 * 1000;	// a ponder search's time budget, it runs until it's stopped
+	void stopPondering();
+	bool _pondering;
+	std::future<int> _ponderMove;
+	std::atomic<bool> _ponderStop;
+	bool _aiPondered;		// _aiMove is a ponder search that hit, it stops at _ponderDeadline
+	int _ponderBudgetMs;	// aiTimeBudget() when the ponder search started
+	std::chrono::steady_clock::time_point _ponderStart;
+	std::chrono::steady_clock::time_point _ponderDeadline;
 };
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+//
+// a read-only file mapped into memory
+//
+// the pages are shared with every other mapping of the same file and only read in as
+// they're touched, so large tables cost nothing to open and can be used from any thread
+//
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // returns false (and stays closed) if the file is missing or empty
+    bool        open(const std::string &path);
+    void        close();
+    bool        isOpen() const { return _mapping != nullptr; }
+
+    const uint8_t *data() const { return static_cast<const uint8_t *>(_mapping); }
+    size_t      size() const { return _size; }
+
+private:
+    void       *_mapping;
+    size_t      _size;
+#ifdef _WIN32
+    void       *_file;
+    void       *_fileMapping;
+#endif
+};
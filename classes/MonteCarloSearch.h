@@ -0,0 +1,574 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "Search.h"
+
+//
+// rollout policies for MonteCarloSearch: pick one of {moves} to play out a game with
+//
+
+// every legal move is as likely as any other
+struct RandomRollout
+{
+    template <typename Position>
+    size_t      choose(const Position &, const std::vector<typename Position::Move> &moves, uint64_t &rng) const
+    {
+        return nextRandom(rng) % moves.size();
+    }
+
+    // xorshift64*, small and fast, one per search thread
+    static uint64_t nextRandom(uint64_t &state)
+    {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return (state * 0x2545f4914f6cdd1dULL) >> 32;
+    }
+};
+
+//
+// monte carlo tree search: UCT over a tree grown one node at a time, with random games
+// played out from its leaves. it needs no evaluation, only the rules, so any game's
+// SearchPosition (see Search.h and SearchPositions.h) can use it as is
+//
+// nodes live in an arena: one block allocated up front, children handed out as a
+// contiguous run by bumping a counter, so growing the tree never calls the allocator and
+// a node's children are next to each other in memory. once it's full the tree stops growing
+// and the playouts carry on from its leaves.
+// with more than one thread every thread walks the same tree. a thread going down through
+// a node adds a virtual loss to it, a visit with nothing won, so the threads behind it
+// spread out over other branches rather than all following the same line, and takes it
+// back once the playout's result is in.
+// between moves the part of the tree under the new position is kept: the search looks up to
+// two plies below the old root for it (its own move and the reply) and copies that subtree
+// into a second arena, which then becomes the live one.
+// every node's wins are counted for the player who made the move into it, 2 for a win and 1
+// for a draw. the move played is the root's most visited child.
+// header only, it's a template
+//
+template <SearchPosition Position, typename Rollout = RandomRollout>
+class MonteCarloSearch
+{
+public:
+    typedef typename Position::Move Move;
+
+    static const int SEARCH_TIME_MS = 500;  // default time budget for one AI move
+    static const size_t DEFAULT_MEGABYTES = 128;
+    static const int MAX_ROLLOUT_PLIES = 400;   // past this the evaluation decides the game
+    static constexpr double EXPLORATION = 1.0;  // the UCT constant, results run from 0 to 1
+
+    MonteCarloSearch()
+    {
+        _timeBudgetMs = SEARCH_TIME_MS;
+        _threadCount = 1;
+        _maxPlayouts = 0;
+        _visitTarget = 0;
+        _exploration = EXPLORATION;
+        _treeReuse = true;
+        _seed = 0x9e3779b97f4a7c15ULL;
+        _megabytes = DEFAULT_MEGABYTES;
+        _live = 0;
+        _hasTree = false;
+        _stop = false;
+        _cancel = nullptr;
+        _playouts = 0;
+        _seconds = 0;
+        _reusedNodes = 0;
+        _winRate = 0;
+    }
+
+    // pick a move for the side to move, false if the game is over. {timeBudgetMs} overrides
+    // setTimeBudget() for this search only, 0 keeps it
+    bool        findBestMove(const Position &position, Move &bestMove, const std::atomic<bool> *cancel = nullptr,
+                             int timeBudgetMs = 0);
+
+    // settings
+    void        setTimeBudget(int milliseconds) { _timeBudgetMs = milliseconds; }
+    int         getTimeBudget() const { return _timeBudgetMs; }
+    void        setThreads(int threads) { _threadCount = threads < 1 ? 1 : threads; }
+    // stop after this many playouts as well, 0 for no limit
+    void        setMaxPlayouts(uint64_t playouts) { _maxPlayouts = playouts; }
+    // stop once the root has this many visits, counting the ones kept from the last search, 0
+    // for no target. a position that was searched ahead of time then needs hardly any more
+    void        setVisitTarget(uint64_t visits) { _visitTarget = visits; }
+    void        setExploration(double exploration) { _exploration = exploration; }
+    void        setTreeReuse(bool reuse) { _treeReuse = reuse; }
+    void        setSeed(uint64_t seed) { _seed = seed ? seed : 1; }
+    // memory for both arenas together, takes effect with the next search
+    void        setArenaSize(size_t megabytes) { _megabytes = megabytes; _arenas[0].nodes.reset(); _hasTree = false; }
+    // throw the tree away, so a search doesn't depend on the ones before it
+    void        clearTree() { _hasTree = false; }
+
+    // statistics from the last search
+    uint64_t    getPlayouts() const { return _playouts; }
+    double      getPlayoutsPerSecond() const { return _seconds > 0 ? _playouts / _seconds : 0.0; }
+    size_t      getTreeNodes() const { return _arenas[_live].used.load(); }
+    size_t      getReusedNodes() const { return _reusedNodes; }
+    // how often the chosen move won its playouts, draws counting half
+    double      getWinRate() const { return _winRate; }
+    // the most visited line from the root, starting with the chosen move
+    std::vector<Move> getPrincipalVariation() const;
+
+private:
+    enum NodeState : uint8_t
+    {
+        UNEXPANDED,
+        EXPANDING,      // a thread is adding its children
+        EXPANDED,
+        TERMINAL        // the game is over here, result holds the margin for the side to move
+    };
+
+    struct Node
+    {
+        Move        move;               // the move that leads here
+        std::atomic<int32_t> visits;
+        std::atomic<int32_t> wins;      // 2 per win and 1 per draw for the player who made the move
+        std::atomic<uint8_t> state;
+        int8_t      result;
+        int8_t      mover;              // the player who made the move
+        uint16_t    childCount;         // only read once state says EXPANDED
+        int32_t     firstChild;
+    };
+
+    struct Arena
+    {
+        std::unique_ptr<Node[]> nodes;
+        size_t      capacity = 0;
+        std::atomic<size_t> used{0};
+    };
+
+    void        allocateArenas();
+    void        resetTree(const Position &position);
+    bool        reuseTree(const Position &position);
+    void        copySubtree(int32_t from);
+    void        initNode(Node &node, const Move &move, int mover);
+    void        searchThread(int id);
+    void        playout(Position &position, std::vector<int32_t> &path, std::vector<Move> &moves, uint64_t &rng);
+    int32_t     selectChild(const Node &node) const;
+    bool        expand(Node &node, const Position &position, std::vector<Move> &moves);
+    int         rollout(Position &position, std::vector<Move> &moves, uint64_t &rng);
+
+    // the winner of a finished game, -1 for a draw, from its margin for the side to move
+    static int  winner(const Position &position, int margin)
+    {
+        return margin > 0 ? position.playerToMove() : margin < 0 ? position.playerToMove() ^ 1 : -1;
+    }
+
+    int         _timeBudgetMs;
+    int         _threadCount;
+    uint64_t    _maxPlayouts;
+    uint64_t    _visitTarget;
+    double      _exploration;
+    bool        _treeReuse;
+    uint64_t    _seed;
+    size_t      _megabytes;
+    Rollout     _rollout;
+
+    // two arenas, the live one and the one the kept subtree is copied into between moves
+    Arena       _arenas[2];
+    int         _live;
+    bool        _hasTree;
+    Position    _rootPosition;          // the position at node 0 of the live arena
+
+    // shared between the threads of one search
+    std::atomic<bool> _stop;
+    std::atomic<uint64_t> _playoutCount;
+    const std::atomic<bool> *_cancel;
+    std::chrono::steady_clock::time_point _deadline;
+
+    uint64_t    _playouts;
+    double      _seconds;
+    size_t      _reusedNodes;
+    double      _winRate;
+};
+
+template <SearchPosition Position, typename Rollout>
+bool MonteCarloSearch<Position, Rollout>::findBestMove(const Position &position, Move &bestMove,
+                                                       const std::atomic<bool> *cancel, int timeBudgetMs)
+{
+    _playouts = 0;
+    _seconds = 0;
+    _reusedNodes = 0;
+    _winRate = 0;
+
+    int margin;
+    if (position.terminal(margin)) {
+        return false;
+    }
+
+    // the clock starts once the arenas are there, allocating them is a one off
+    allocateArenas();
+    auto start = std::chrono::steady_clock::now();
+    if (!_treeReuse || !_hasTree || !reuseTree(position)) {
+        resetTree(position);
+    }
+    Arena &arena = _arenas[_live];
+    Node &root = arena.nodes[0];
+    std::vector<Move> moves;
+    if (root.state.load() == UNEXPANDED && !expand(root, _rootPosition, moves)) {
+        // the kept tree left no room for the root's children, start over
+        resetTree(position);
+        expand(root, _rootPosition, moves);
+    }
+    if (root.childCount == 1) {
+        bestMove = arena.nodes[root.firstChild].move;
+        return true;    // nothing to think about
+    }
+
+    _stop = false;
+    _cancel = cancel;
+    _playoutCount = 0;
+    _deadline = start + std::chrono::milliseconds(timeBudgetMs > 0 ? timeBudgetMs : _timeBudgetMs);
+
+    std::vector<std::thread> helpers;
+    if (!_visitTarget || (uint64_t)root.visits.load() < _visitTarget) {
+        for (int i = 1; i < _threadCount; i++) {
+            helpers.emplace_back([this, i]() { searchThread(i); });
+        }
+        searchThread(0);
+    }
+    _stop = true;
+    for (std::thread &helper : helpers) {
+        helper.join();
+    }
+
+    // the most visited move is the one the search trusts most
+    int32_t best = root.firstChild;
+    for (int32_t child = root.firstChild; child < root.firstChild + root.childCount; child++) {
+        if (arena.nodes[child].visits.load() > arena.nodes[best].visits.load()) {
+            best = child;
+        }
+    }
+    bestMove = arena.nodes[best].move;
+    int visits = arena.nodes[best].visits.load();
+    _winRate = visits ? arena.nodes[best].wins.load() / (2.0 * visits) : 0.0;
+    _playouts = _playoutCount.load();
+    _seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+template <SearchPosition Position, typename Rollout>
+std::vector<typename Position::Move> MonteCarloSearch<Position, Rollout>::getPrincipalVariation() const
+{
+    std::vector<Move> line;
+    if (!_hasTree) {
+        return line;
+    }
+    const Arena &arena = _arenas[_live];
+    const Node *node = &arena.nodes[0];
+    while (node->state.load() == EXPANDED && node->childCount > 0) {
+        const Node *best = &arena.nodes[node->firstChild];
+        for (int i = 1; i < node->childCount; i++) {
+            const Node &child = arena.nodes[node->firstChild + i];
+            if (child.visits.load() > best->visits.load()) {
+                best = &child;
+            }
+        }
+        if (best->visits.load() == 0) {
+            break;
+        }
+        line.push_back(best->move);
+        node = best;
+    }
+    return line;
+}
+
+// both arenas are allocated the first time they're needed, a game that never uses this pays nothing
+template <SearchPosition Position, typename Rollout>
+void MonteCarloSearch<Position, Rollout>::allocateArenas()
+{
+    if (_arenas[0].nodes) {
+        return;
+    }
+    size_t capacity = std::max<size_t>(_megabytes * 1024 * 1024 / 2 / sizeof(Node), 1024);
+    for (Arena &arena : _arenas) {
+        arena.nodes = std::make_unique<Node[]>(capacity);
+        arena.capacity = capacity;
+        arena.used = 0;
+    }
+    _hasTree = false;
+}
+
+template <SearchPosition Position, typename Rollout>
+void MonteCarloSearch<Position, Rollout>::initNode(Node &node, const Move &move, int mover)
+{
+    node.move = move;
+    node.mover = (int8_t)mover;
+    node.visits.store(0, std::memory_order_relaxed);
+    node.wins.store(0, std::memory_order_relaxed);
+    node.state.store(UNEXPANDED, std::memory_order_relaxed);
+    node.result = 0;
+    node.childCount = 0;
+    node.firstChild = -1;
+}
+
+template <SearchPosition Position, typename Rollout>
+void MonteCarloSearch<Position, Rollout>::resetTree(const Position &position)
+{
+    Arena &arena = _arenas[_live];
+    initNode(arena.nodes[0], Move(), position.playerToMove() ^ 1);
+    arena.used = 1;
+    _rootPosition = position;
+    _hasTree = true;
+}
+
+//
+// look for {position} at the old root or among its children and grandchildren, and if it's
+// there make its subtree the new tree
+//
+template <SearchPosition Position, typename Rollout>
+bool MonteCarloSearch<Position, Rollout>::reuseTree(const Position &position)
+{
+    const Arena &arena = _arenas[_live];
+    uint64_t key = position.key();
+    int player = position.playerToMove();
+    const Node &root = arena.nodes[0];
+    if (root.state.load() != EXPANDED) {
+        return false;
+    }
+    if (_rootPosition.key() == key && _rootPosition.playerToMove() == player) {
+        _reusedNodes = arena.used.load();
+        return true;    // the same position again, the whole tree is still good
+    }
+
+    for (int32_t child = root.firstChild; child < root.firstChild + root.childCount; child++) {
+        Position after = _rootPosition;
+        Move move = arena.nodes[child].move;
+        after.play(move);
+        if (after.key() == key && after.playerToMove() == player) {
+            copySubtree(child);
+            _rootPosition = position;
+            return true;
+        }
+        const Node &node = arena.nodes[child];
+        if (node.state.load() != EXPANDED) {
+            continue;
+        }
+        for (int32_t grandchild = node.firstChild; grandchild < node.firstChild + node.childCount; grandchild++) {
+            Position reply = after;
+            Move replyMove = arena.nodes[grandchild].move;
+            reply.play(replyMove);
+            if (reply.key() == key && reply.playerToMove() == player) {
+                copySubtree(grandchild);
+                _rootPosition = position;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// copy the subtree under {from} in the live arena to the other one, breadth first so every
+// node's children stay together, and make that arena the live one
+template <SearchPosition Position, typename Rollout>
+void MonteCarloSearch<Position, Rollout>::copySubtree(int32_t from)
+{
+    Arena &source = _arenas[_live];
+    Arena &target = _arenas[_live ^ 1];
+
+    auto copyNode = [](const Node &node, Node &copy) {
+        copy.move = node.move;
+        copy.visits.store(node.visits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        copy.wins.store(node.wins.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        // a leaf that never got its children for lack of room can have them now
+        uint8_t state = node.state.load(std::memory_order_relaxed);
+        copy.state.store(state == EXPANDING ? (uint8_t)UNEXPANDED : state, std::memory_order_relaxed);
+        copy.result = node.result;
+        copy.mover = node.mover;
+        copy.childCount = 0;
+        copy.firstChild = -1;
+    };
+
+    copyNode(source.nodes[from], target.nodes[0]);
+    size_t used = 1;
+    std::vector<std::pair<int32_t, int32_t>> queue = {{from, 0}};
+    for (size_t next = 0; next < queue.size(); next++) {
+        const Node &node = source.nodes[queue[next].first];
+        Node &copy = target.nodes[queue[next].second];
+        if (node.state.load(std::memory_order_relaxed) != EXPANDED) {
+            continue;
+        }
+        copy.firstChild = (int32_t)used;
+        copy.childCount = node.childCount;
+        for (int i = 0; i < node.childCount; i++) {
+            copyNode(source.nodes[node.firstChild + i], target.nodes[used]);
+            queue.push_back({node.firstChild + i, (int32_t)used});
+            used++;
+        }
+    }
+    target.used = used;
+    _live ^= 1;
+    _reusedNodes = used;
+}
+
+// one search thread: playouts until the clock, the playout limit or the cancel flag says stop
+template <SearchPosition Position, typename Rollout>
+void MonteCarloSearch<Position, Rollout>::searchThread(int id)
+{
+    uint64_t rng = _seed + 0x9e3779b97f4a7c15ULL * (uint64_t)(id + 1);
+    std::vector<int32_t> path;
+    std::vector<Move> moves;
+    Position position;
+
+    for (uint64_t count = 0; !_stop.load(std::memory_order_relaxed); count++) {
+        position = _rootPosition;
+        playout(position, path, moves, rng);
+
+        uint64_t total = _playoutCount.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (_maxPlayouts && total >= _maxPlayouts) {
+            _stop = true;
+        }
+        if (_visitTarget && (uint64_t)_arenas[_live].nodes[0].visits.load(std::memory_order_relaxed) >= _visitTarget) {
+            _stop = true;
+        }
+        // only the first thread watches the clock, every few dozen playouts
+        if (id == 0 && (count & 63) == 0) {
+            if ((_cancel && _cancel->load()) || std::chrono::steady_clock::now() >= _deadline) {
+                _stop = true;
+            }
+        }
+    }
+}
+
+//
+// one iteration: go down the tree by UCT with a virtual loss on every node passed, grow it
+// by a node's children once that node has been visited before, play a random game out from
+// there and count the result on the way back up
+//
+template <SearchPosition Position, typename Rollout>
+void MonteCarloSearch<Position, Rollout>::playout(Position &position, std::vector<int32_t> &path,
+                                                  std::vector<Move> &moves, uint64_t &rng)
+{
+    Arena &arena = _arenas[_live];
+    path.clear();
+    path.push_back(0);
+    arena.nodes[0].visits.fetch_add(1, std::memory_order_relaxed);
+
+    int32_t index = 0;
+    int result = -2;
+    for (;;) {
+        Node &node = arena.nodes[index];
+        uint8_t state = node.state.load(std::memory_order_acquire);
+        if (state == TERMINAL) {
+            result = winner(position, node.result);
+            break;
+        }
+        if (state != EXPANDED) {
+            // a leaf: the first visit plays out from here, the next one adds its children
+            if (state == UNEXPANDED && node.visits.load(std::memory_order_relaxed) > 1 && expand(node, position, moves)) {
+                continue;
+            }
+            if (node.state.load(std::memory_order_acquire) == TERMINAL) {
+                continue;
+            }
+            break;
+        }
+
+        index = selectChild(node);
+        Node &child = arena.nodes[index];
+        child.visits.fetch_add(1, std::memory_order_relaxed);  // the virtual loss, a visit with no win yet
+        Move move = child.move;
+        position.play(move);
+        path.push_back(index);
+    }
+
+    if (result == -2) {
+        result = rollout(position, moves, rng);
+    }
+
+    // the visits went in on the way down, only the wins are left to add
+    for (size_t i = 1; i < path.size(); i++) {
+        Node &node = arena.nodes[path[i]];
+        int reward = result < 0 ? 1 : result == node.mover ? 2 : 0;
+        if (reward) {
+            node.wins.fetch_add(reward, std::memory_order_relaxed);
+        }
+    }
+}
+
+// the child with the best upper confidence bound, unvisited ones first
+template <SearchPosition Position, typename Rollout>
+int32_t MonteCarloSearch<Position, Rollout>::selectChild(const Node &node) const
+{
+    const Arena &arena = _arenas[_live];
+    double logVisits = std::log((double)std::max(node.visits.load(std::memory_order_relaxed), 1));
+    int32_t best = node.firstChild;
+    double bestValue = -1.0;
+    for (int32_t child = node.firstChild; child < node.firstChild + node.childCount; child++) {
+        const Node &candidate = arena.nodes[child];
+        int visits = candidate.visits.load(std::memory_order_relaxed);
+        if (visits == 0) {
+            return child;
+        }
+        double value = candidate.wins.load(std::memory_order_relaxed) / (2.0 * visits) +
+                       _exploration * std::sqrt(logVisits / visits);
+        if (value > bestValue) {
+            bestValue = value;
+            best = child;
+        }
+    }
+    return best;
+}
+
+//
+// give {node} its children, false if another thread is already doing it or the arena is
+// full. a finished game becomes a terminal node instead
+//
+template <SearchPosition Position, typename Rollout>
+bool MonteCarloSearch<Position, Rollout>::expand(Node &node, const Position &position, std::vector<Move> &moves)
+{
+    uint8_t expected = UNEXPANDED;
+    if (!node.state.compare_exchange_strong(expected, EXPANDING, std::memory_order_acquire)) {
+        return false;
+    }
+
+    int margin;
+    if (position.terminal(margin)) {
+        node.result = (int8_t)(margin > 0 ? 1 : margin < 0 ? -1 : 0);
+        node.state.store(TERMINAL, std::memory_order_release);
+        return true;
+    }
+
+    moves.clear();
+    position.generate(moves);
+    Arena &arena = _arenas[_live];
+    size_t first = arena.used.fetch_add(moves.size(), std::memory_order_relaxed);
+    if (first + moves.size() > arena.capacity) {
+        // out of room, this node stays a leaf for good
+        arena.used.store(arena.capacity, std::memory_order_relaxed);
+        node.state.store(EXPANDING, std::memory_order_release);
+        return false;
+    }
+    for (size_t i = 0; i < moves.size(); i++) {
+        initNode(arena.nodes[first + i], moves[i], position.playerToMove());
+    }
+    node.firstChild = (int32_t)first;
+    node.childCount = (uint16_t)moves.size();
+    node.state.store(EXPANDED, std::memory_order_release);
+    return true;
+}
+
+// play random moves to the end of the game, returns the winner or -1 for a draw
+template <SearchPosition Position, typename Rollout>
+int MonteCarloSearch<Position, Rollout>::rollout(Position &position, std::vector<Move> &moves, uint64_t &rng)
+{
+    for (int ply = 0; ply < MAX_ROLLOUT_PLIES; ply++) {
+        int margin;
+        if (position.terminal(margin)) {
+            return winner(position, margin);
+        }
+        moves.clear();
+        position.generate(moves);
+        Move move = moves[_rollout.choose(position, moves, rng)];
+        position.play(move);
+    }
+    // a game that won't end, the evaluation calls it
+    return winner(position, position.evaluate());
+}
@@ -1,19 +1,26 @@
 #include "Othello.h"
+#include "Logger.h"
 #include <iostream>
 
-// Define the 8 directions: N, NE, E, SE, S, SW, W, NW
-const int Othello::DIRECTIONS[8][2] = {
-    {0, -1}, {1, -1}, {1, 0}, {1, 1},
-    {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}
-};
-
 Othello::Othello() : Game() {
     _grid = new Grid(8, 8);
     _consecutivePasses = 0;
     _showingHints = false;
+    _monteCarlo = false;
+    _ponderExpected = false;
+    _playoutRate = 0;
+    _monteCarloSearch.setThreads((int)std::thread::hardware_concurrency());
+    // trained pattern weights if they're there, the hand-tuned evaluation if not
+    if (_patterns.open(OthelloPatterns::DEFAULT_FILE)) {
+        _search.setPatterns(&_patterns);
+    } else {
+        Logger *logger = Logger::GetInstance();
+        logger->Log(std::string("no pattern weights at ") + OthelloPatterns::DEFAULT_FILE + ", build them with the othello_weights target", logger->WARN, logger->GAME);
+    }
 }
 
 Othello::~Othello() {
+    cancelAISearch();
     delete _grid;
 }
 
@@ -24,21 +31,10 @@ void Othello::setUpBoard() {
 
     _grid->initializeSquares(80, "boardsquare.png");
 
-    // Set up initial four pieces in the center
-    Player* blackPlayer = getPlayerAt(BLACK_PLAYER);
-    Player* whitePlayer = getPlayerAt(WHITE_PLAYER);
-
-    // Standard Othello starting position
-    auto placePiece = [&](int x, int y, Player* player) {
-        Bit* piece = createPiece(player);
-        piece->setPosition(_grid->getSquare(x, y)->getPosition());
-        _grid->getSquare(x, y)->setBit(piece);
-    };
-
-    placePiece(3, 3, whitePlayer);  // White at (3,3)
-    placePiece(4, 4, whitePlayer);  // White at (4,4)
-    placePiece(4, 3, blackPlayer);  // Black at (4,3)
-    placePiece(3, 4, blackPlayer);  // Black at (3,4)
+    // Standard Othello starting position, the pieces come from the bitboards
+    _position.reset();
+    _consecutivePasses = 0;
+    syncPieces(~0ULL);
 
     if (gameHasAI()) {
         setAIPlayer(AI_PLAYER);
@@ -58,27 +54,20 @@ bool Othello::actionForEmptyHolder(BitHolder &holder) {
     if (holder.bit()) return false;
 
     ChessSquare* square = static_cast<ChessSquare*>(&holder);
-    int x = square->getColumn();
-    int y = square->getRow();
-    Player* currentPlayer = getCurrentPlayer();
+    int index = square->getRow() * 8 + square->getColumn();
+    if (!_position.canPlay(index)) return false;
 
-    if (!isValidMove(x, y, currentPlayer)) return false;
-
-    // Place the piece
-    Bit* newPiece = createPiece(currentPlayer);
-    newPiece->setPosition(holder.getPosition());
-    holder.setBit(newPiece);
-
-    // Flip all affected pieces
-    flipPieces(x, y, currentPlayer);
+    // Place the piece and flip, then redraw just the squares that changed
+    uint64_t flipped = _position.play(index);
+    syncPieces(flipped | (1ULL << index));
     _consecutivePasses = 0;
 
     // Check if next player has moves
-    Player* nextPlayer = getPlayerAt(1 - currentPlayer->playerNumber());
-    if (!hasValidMove(nextPlayer)) {
+    if (_position.mustPass()) {
         _consecutivePasses++;
-        if (hasValidMove(currentPlayer)) {
+        if (!_position.isGameOver()) {
             // Next player passes, current player continues
+            _position.pass();
             return true;
         } else {
             _consecutivePasses = 2; // Game ends
@@ -97,234 +86,163 @@ bool Othello::canBitMoveFromTo(Bit &bit, BitHolder &src, BitHolder &dst) {
     return false; // Pieces cannot be moved in Othello
 }
 
-bool Othello::isValidMove(int x, int y, Player* player) const {
-    if (!_grid->isValid(x, y) || _grid->getSquare(x, y)->bit()) return false;
-
-    // Check if placing a piece here would flip at least one opponent piece
-    for (int i = 0; i < 8; i++) {
-        if (checkDirection(x, y, DIRECTIONS[i][0], DIRECTIONS[i][1], player) > 0) {
-            return true;
-        }
-    }
-    return false;
-}
-
-int Othello::checkDirection(int x, int y, int dx, int dy, Player* player) const {
-    int count = 0;
-    int nx = x + dx;
-    int ny = y + dy;
-
-    if (!_grid->isValid(nx, ny)) return 0;
-
-    Bit* firstPiece = _grid->getSquare(nx, ny)->bit();
-    if (!firstPiece || firstPiece->getOwner() == player) return 0;
-
-    // Count opponent pieces in this direction
-    while (_grid->isValid(nx, ny)) {
-        Bit* piece = _grid->getSquare(nx, ny)->bit();
-        if (!piece) return 0;
-        if (piece->getOwner() == player) return count;
-        count++;
-        nx += dx;
-        ny += dy;
-    }
-    return 0;
-}
-
-void Othello::flipPieces(int x, int y, Player* player) {
-    for (int i = 0; i < 8; i++) {
-        int count = checkDirection(x, y, DIRECTIONS[i][0], DIRECTIONS[i][1], player);
-        if (count > 0) {
-            flipInDirection(x, y, DIRECTIONS[i][0], DIRECTIONS[i][1], player, count);
-        }
-    }
-}
-
-void Othello::flipInDirection(int x, int y, int dx, int dy, Player* player, int count) {
-    int nx = x + dx;
-    int ny = y + dy;
-
-    for (int i = 0; i < count; i++) {
-        ChessSquare* square = _grid->getSquare(nx, ny);
-        if (square && square->bit()) {
-            square->destroyBit();
-            Bit* newPiece = createPiece(player);
-            newPiece->setPosition(square->getPosition());
-            square->setBit(newPiece);
-        }
-        nx += dx;
-        ny += dy;
-    }
-}
-
-bool Othello::hasValidMove(Player* player) const {
-    bool hasMove = false;
+//
+// rebuild the pieces on the squares in {squares} from the bitboards
+//
+void Othello::syncPieces(uint64_t squares) {
     _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
-        if (!hasMove && isValidMove(x, y, player)) {
-            hasMove = true;
-        }
-    });
-    return hasMove;
-}
+        int index = y * 8 + x;
+        if (!((squares >> index) & 1)) return;
 
-std::vector<std::pair<int, int>> Othello::getValidMoves(Player* player) const {
-    std::vector<std::pair<int, int>> moves;
-    _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
-        if (isValidMove(x, y, player)) {
-            moves.push_back({x, y});
+        square->destroyBit();
+        int owner = ((_position.board(OthelloPosition::BLACK) >> index) & 1) ? BLACK_PLAYER
+                  : ((_position.board(OthelloPosition::WHITE) >> index) & 1) ? WHITE_PLAYER : -1;
+        if (owner >= 0) {
+            Bit* piece = createPiece(getPlayerAt(owner));
+            piece->setPosition(square->getPosition());
+            square->setBit(piece);
         }
     });
-    return moves;
 }
 
 Player* Othello::checkForWinner() {
-    // Game ends when neither player can move
-    if (_consecutivePasses >= 2 ||
-        (!hasValidMove(getPlayerAt(BLACK_PLAYER)) && !hasValidMove(getPlayerAt(WHITE_PLAYER)))) {
-
-        int blackCount, whiteCount;
-        countPieces(blackCount, whiteCount);
-
-        if (blackCount > whiteCount) return getPlayerAt(BLACK_PLAYER);
-        if (whiteCount > blackCount) return getPlayerAt(WHITE_PLAYER);
-    }
-
-    // Check if board is full
-    bool boardFull = true;
-    _grid->forEachSquare([&boardFull](ChessSquare* square, int x, int y) {
-        if (!square->bit()) boardFull = false;
-    });
-
-    if (boardFull) {
-        int blackCount, whiteCount;
-        countPieces(blackCount, whiteCount);
+    // Game ends when neither player can move, which includes a full board
+    if (_consecutivePasses >= 2 || _position.isGameOver()) {
+        int blackCount = _position.discCount(OthelloPosition::BLACK);
+        int whiteCount = _position.discCount(OthelloPosition::WHITE);
         if (blackCount > whiteCount) return getPlayerAt(BLACK_PLAYER);
         if (whiteCount > blackCount) return getPlayerAt(WHITE_PLAYER);
     }
-
     return nullptr;
 }
 
 bool Othello::checkForDraw() {
-    if (_consecutivePasses >= 2 ||
-        (!hasValidMove(getPlayerAt(BLACK_PLAYER)) && !hasValidMove(getPlayerAt(WHITE_PLAYER)))) {
-        int blackCount, whiteCount;
-        countPieces(blackCount, whiteCount);
-        return blackCount == whiteCount;
-    }
-
-    bool boardFull = true;
-    _grid->forEachSquare([&boardFull](ChessSquare* square, int x, int y) {
-        if (!square->bit()) boardFull = false;
-    });
-
-    if (boardFull) {
-        int blackCount, whiteCount;
-        countPieces(blackCount, whiteCount);
-        return blackCount == whiteCount;
+    if (_consecutivePasses >= 2 || _position.isGameOver()) {
+        return _position.discCount(OthelloPosition::BLACK) == _position.discCount(OthelloPosition::WHITE);
     }
     return false;
 }
 
-void Othello::countPieces(int &blackCount, int &whiteCount) const {
-    blackCount = 0;
-    whiteCount = 0;
-
-    _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
-        Bit* piece = square->bit();
-        if (piece) {
-            if (piece->getOwner() == getPlayerAt(BLACK_PLAYER)) {
-                blackCount++;
-            } else {
-                whiteCount++;
-            }
-        }
-    });
-}
-
 void Othello::stopGame() {
+    cancelAISearch();
     _grid->forEachSquare([](ChessSquare* square, int x, int y) {
         square->destroyBit();
     });
+    _position.reset();
     _consecutivePasses = 0;
 }
 
 std::string Othello::initialStateString() {
-    std::string state(64, '0');
-    state[3 * 8 + 3] = '2';  // White at (3,3)
-    state[4 * 8 + 4] = '2';  // White at (4,4)
-    state[4 * 8 + 3] = '1';  // Black at (4,3)
-    state[3 * 8 + 4] = '1';  // Black at (3,4)
-    return state;
+    return OthelloPosition().state();
 }
 
 std::string Othello::stateString() {
-    std::string state;
-    _grid->forEachSquare([&state, this](ChessSquare* square, int x, int y) {
-        Bit* bit = square->bit();
-        if (!bit) {
-            state += '0';
-        } else if (bit->getOwner() == getPlayerAt(BLACK_PLAYER)) {
-            state += '1';
-        } else {
-            state += '2';
-        }
-    });
-    return state;
+    return _position.state();
 }
 
 void Othello::setStateString(const std::string &s) {
-    if (s.length() != 64) return;
+    if (!_position.setState(s, getCurrentTurnNo() & 1)) return;
+    syncPieces(~0ULL);
+}
 
-    int index = 0;
-    _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
-        if (index < s.length()) {
-            char pieceType = s[index++];
-            square->destroyBit();
-
-            if (pieceType == '1') {
-                Bit* piece = createPiece(getPlayerAt(BLACK_PLAYER));
-                piece->setPosition(square->getPosition());
-                square->setBit(piece);
-            } else if (pieceType == '2') {
-                Bit* piece = createPiece(getPlayerAt(WHITE_PLAYER));
-                piece->setPosition(square->getPosition());
-                square->setBit(piece);
+//
+// snapshot the bitboards and pick the move on a worker thread
+//
+std::future<int> Othello::startAISearch() {
+    if (!gameHasAI() || checkForWinner() || checkForDraw()) return std::future<int>();
+
+    OthelloPosition position = _position;
+    return std::async(std::launch::async, [this, position]() {
+        if (_monteCarlo) {
+            // after pondering, stop as soon as the tree is as big as a search of our own would have made it
+            _monteCarloSearch.setVisitTarget(_pondering ? (uint64_t)(_playoutRate * _monteCarloSearch.getTimeBudget() / 1000) : 0);
+            OthelloSearchPosition::Move move = {-1, 0};
+            _monteCarloSearch.findBestMove(OthelloSearchPosition(position), move, &_aiCancel);
+            if (_monteCarloSearch.getPlayouts() > 0) {
+                _playoutRate = _monteCarloSearch.getPlayoutsPerSecond();
             }
+            return move.square;
         }
+        return _search.findBestMove(position, &_aiCancel);
     });
 }
 
-void Othello::updateAI() {
-    if (!gameHasAI()) return;
-
-    Player* aiPlayer = getCurrentPlayer();
-    std::vector<std::pair<int, int>> validMoves = getValidMoves(aiPlayer);
-
-    if (validMoves.empty()) {
-        _consecutivePasses++;
-        endTurn();
-        return;
+//
+// search on the human's turn. the alpha-beta search takes the reply its last principal variation
+// expects and searches the position after it, the table it fills stays useful if the human plays
+// something else. the monte carlo search searches the position the human has in front of them, so
+// whatever they play its tree has a subtree for it
+//
+std::future<int> Othello::startPonder() {
+    _ponderExpected = false;
+    if (checkForWinner() || checkForDraw()) return std::future<int>();
+
+    if (_monteCarlo) {
+        OthelloPosition position = _position;
+        return std::async(std::launch::async, [this, position]() {
+            OthelloSearchPosition::Move move = {-1, 0};
+            _monteCarloSearch.setVisitTarget(0);
+            _monteCarloSearch.findBestMove(OthelloSearchPosition(position), move, &_ponderStop, PONDER_TIME_MS);
+            if (_monteCarloSearch.getPlayouts() > 0) {
+                _playoutRate = _monteCarloSearch.getPlayoutsPerSecond();
+            }
+            return move.square;
+        });
     }
 
-    // Find move that flips the most pieces
-    int bestX = -1, bestY = -1, maxFlips = 0;
+    // the principal variation starts with the AI's own move, the human's reply is next
+    const std::vector<int> &line = _search.getPrincipalVariation();
+    if (line.size() < 2 || line[1] < 0 || !_position.canPlay(line[1])) return std::future<int>();
+    _ponderPosition = _position;
+    _ponderPosition.play(line[1]);
+    // if the AI would have to pass the human just moves again, there's nothing to ponder
+    if (_ponderPosition.mustPass()) return std::future<int>();
+    _ponderExpected = true;
+
+    OthelloPosition position = _ponderPosition;
+    return std::async(std::launch::async, [this, position]() {
+        return _search.findBestMove(position, &_ponderStop, PONDER_TIME_MS);
+    });
+}
+
+// the monte carlo search never hits, its tree is picked up by the search that follows
+bool Othello::ponderHit() {
+    return _ponderExpected &&
+           _ponderPosition.board(OthelloPosition::BLACK) == _position.board(OthelloPosition::BLACK) &&
+           _ponderPosition.board(OthelloPosition::WHITE) == _position.board(OthelloPosition::WHITE) &&
+           _ponderPosition.playerToMove() == _position.playerToMove();
+}
 
-    for (const auto& move : validMoves) {
-        int x = move.first, y = move.second, totalFlips = 0;
-        for (int i = 0; i < 8; i++) {
-            totalFlips += checkDirection(x, y, DIRECTIONS[i][0], DIRECTIONS[i][1], aiPlayer);
-        }
-        if (totalFlips > maxFlips) {
-            maxFlips = totalFlips;
-            bestX = x;
-            bestY = y;
+// a move is a square index (y * 8 + x), or -1 to pass
+void Othello::applyAIMove(int move) {
+    Logger *logger = Logger::GetInstance();
+    // the expected line in the usual notation, columns a-h and rows 1-8 from the top
+    std::vector<int> line;
+    if (_monteCarlo) {
+        for (const OthelloSearchPosition::Move &played : _monteCarloSearch.getPrincipalVariation()) {
+            line.push_back(played.square);
         }
+    } else {
+        line = _search.getPrincipalVariation();
+    }
+    _aiLine.clear();
+    for (int square : line) {
+        std::string name = (square < 0) ? "pass" : std::string(1, (char)('a' + square % 8)) + std::to_string(square / 8 + 1);
+        _aiLine += (_aiLine.empty() ? "" : " ") + name;
+    }
+    if (_monteCarlo) {
+        logger->Log("AI ran " + std::to_string(_monteCarloSearch.getPlayouts()) + " playouts (" + std::to_string((int)_monteCarloSearch.getPlayoutsPerSecond()) + " a second), expecting " + _aiLine, logger->INFO, logger->GAME);
+    } else {
+        logger->Log("AI searched " + std::to_string(_search.getNodesSearched()) + " nodes to depth " + std::to_string(_search.getCompletedDepth()) + ", expecting " + _aiLine, logger->INFO, logger->GAME);
     }
 
-    if (bestX >= 0 && bestY >= 0) {
-        actionForEmptyHolder(*_grid->getSquare(bestX, bestY));
+    if (move < 0) {
+        _consecutivePasses++;
+        _position.pass();
+        endTurn();
+        return;
     }
+    actionForEmptyHolder(*_grid->getSquare(move % 8, move / 8));
 }
 
 void Othello::getBoardPosition(BitHolder& holder, int &x, int &y) const {
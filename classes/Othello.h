@@ -1,5 +1,9 @@
 #pragma once
 #include "Game.h"
+#include "OthelloPosition.h"
+#include "OthelloSearch.h"
+#include "MonteCarloSearch.h"
+#include "SearchPositions.h"
 #include <vector>
 
 // NOTE: This implementation assumes black.png and white.png exist in resources.
@@ -24,35 +28,47 @@ public:
     void        stopGame() override;
 
     // AI methods
-    void        updateAI() override;
+    std::future<int> startAISearch() override;
+    void        applyAIMove(int move) override;
+    std::string aiExpectedLine() override { return _aiLine; }
+    void        setMonteCarloAI(bool monteCarlo) override { _monteCarlo = monteCarlo; }
+    std::future<int> startPonder() override;
+    bool        ponderHit() override;
+    int         aiTimeBudget() override { return _monteCarlo ? _monteCarloSearch.getTimeBudget() : _search.getTimeBudget(); }
     bool        gameHasAI() override { return true; } // Set to true when AI is implemented
     Grid* getGrid() override { return _grid; }
 
+    // AI tuning and stats
+    void        setSearchTimeBudget(int milliseconds) { _search.setTimeBudget(milliseconds); }
+    uint64_t    getNodesSearched() const { return _search.getNodesSearched(); }
+
 private:
     // Player constants
     static const int BLACK_PLAYER = 0;
     static const int WHITE_PLAYER = 1;
 
-    // Direction vectors for checking all 8 directions
-    static const int DIRECTIONS[8][2];
-
     // Helper methods
     Bit*        createPiece(Player* player);
-    bool        isValidMove(int x, int y, Player* player) const;
-    int         checkDirection(int x, int y, int dx, int dy, Player* player) const;
-    void        flipPieces(int x, int y, Player* player);
-    void        flipInDirection(int x, int y, int dx, int dy, Player* player, int count);
-    bool        hasValidMove(Player* player) const;
-    void        countPieces(int &blackCount, int &whiteCount) const;
-    std::vector<std::pair<int, int>> getValidMoves(Player* player) const;
+    void        syncPieces(uint64_t squares);
     void        showValidMoves(Player* player);
     void        clearValidMoveIndicators();
 
     // Board position helper
     void        getBoardPosition(BitHolder& holder, int &x, int &y) const;
 
-    // Board representation
+    // Board representation, the bitboards are the real state and the grid just shows them
     Grid*       _grid;
+    OthelloPosition _position;
+
+    // AI search engine, searches its own copy of the position on a worker thread
+    OthelloPatterns _patterns;      // declared first so it outlives the search that uses it
+    OthelloSearch _search;
+    MonteCarloSearch<OthelloSearchPosition> _monteCarloSearch;
+    bool        _monteCarlo;        // search with _monteCarloSearch instead of _search
+    OthelloPosition _ponderPosition;    // the position the ponder search is on
+    bool        _ponderExpected;    // there is one, the monte carlo search doesn't need it
+    double      _playoutRate;       // playouts a second in the last monte carlo search that ran any
+    std::string _aiLine;            // the search's principal variation behind the last AI move
 
     // Game state
     int         _consecutivePasses;
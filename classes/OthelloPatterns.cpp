@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include "OthelloPatterns.h"
+#include "OthelloPosition.h"
+
+// the squares of each shape as x, y pairs, ending at -1
+static const int SHAPE_SQUARES[OthelloPatterns::SHAPES][2 * OthelloPatterns::MAX_SQUARES + 1] = {
+    {0, 1, 1, 1, 2, 1, 3, 1, 4, 1, 5, 1, 6, 1, 7, 1, -1},                 // second row
+    {0, 2, 1, 2, 2, 2, 3, 2, 4, 2, 5, 2, 6, 2, 7, 2, -1},                 // third row
+    {0, 3, 1, 3, 2, 3, 3, 3, 4, 3, 5, 3, 6, 3, 7, 3, -1},                 // fourth row
+    {0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, -1},                 // long diagonal
+    {0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, -1},                       // diagonals of 7 to 4
+    {0, 2, 1, 3, 2, 4, 3, 5, 4, 6, 5, 7, -1},
+    {0, 3, 1, 4, 2, 5, 3, 6, 4, 7, -1},
+    {0, 4, 1, 5, 2, 6, 3, 7, -1},
+    {0, 0, 1, 0, 2, 0, 3, 0, 4, 0, 5, 0, 6, 0, 7, 0, 1, 1, 6, 1, -1},     // edge and its X squares
+    {0, 0, 1, 0, 2, 0, 3, 0, 4, 0, 0, 1, 1, 1, 2, 1, 3, 1, 4, 1, -1},     // 2x5 corner block
+    {0, 0, 1, 0, 2, 0, 0, 1, 1, 1, 2, 1, 0, 2, 1, 2, 2, 2, -1}            // 3x3 corner block
+};
+
+static const int MAX_PER_SQUARE = 16;
+
+//
+// every instance of every shape, and for each square the instances it's part of and the
+// power of 3 it has in each of them
+//
+struct PatternTables
+{
+    int      shape[OthelloPatterns::INSTANCES];
+    int      offset[OthelloPatterns::INSTANCES];
+    int      size[OthelloPatterns::INSTANCES];
+    int      squares[OthelloPatterns::INSTANCES][OthelloPatterns::MAX_SQUARES];
+
+    int      squareCount[64];
+    uint16_t squareInstance[64][MAX_PER_SQUARE];
+    uint16_t squarePower[64][MAX_PER_SQUARE];
+
+    PatternTables()
+    {
+        std::fill(squareCount, squareCount + 64, 0);
+        int instances = 0;
+        int shapeOffset = 0;
+
+        for (int s = 0; s < OthelloPatterns::SHAPES; s++) {
+            int length = 0;
+            while (SHAPE_SQUARES[s][2 * length] >= 0) length++;
+
+            // the shape under all 8 symmetries, keeping each set of squares once
+            std::vector<uint64_t> seen;
+            for (int symmetry = 0; symmetry < 8; symmetry++) {
+                int mapped[OthelloPatterns::MAX_SQUARES];
+                uint64_t set = 0;
+                for (int i = 0; i < length; i++) {
+                    int x = SHAPE_SQUARES[s][2 * i];
+                    int y = SHAPE_SQUARES[s][2 * i + 1];
+                    if (symmetry & 4) std::swap(x, y);
+                    if (symmetry & 1) x = 7 - x;
+                    if (symmetry & 2) y = 7 - y;
+                    mapped[i] = y * 8 + x;
+                    set |= 1ULL << mapped[i];
+                }
+                if (std::find(seen.begin(), seen.end(), set) != seen.end()) continue;
+                seen.push_back(set);
+
+                int power = 1;
+                for (int i = 0; i < length; i++) {
+                    int square = mapped[i];
+                    squares[instances][i] = square;
+                    squareInstance[square][squareCount[square]] = (uint16_t)instances;
+                    squarePower[square][squareCount[square]] = (uint16_t)power;
+                    squareCount[square]++;
+                    power *= 3;
+                }
+                shape[instances] = s;
+                offset[instances] = shapeOffset;
+                size[instances] = length;
+                instances++;
+            }
+
+            int tableSize = 1;
+            for (int i = 0; i < length; i++) tableSize *= 3;
+            shapeOffset += tableSize;
+        }
+    }
+};
+
+static const PatternTables TABLES;
+
+OthelloPatterns::OthelloPatterns()
+{
+    _weights = nullptr;
+}
+
+OthelloPatterns::~OthelloPatterns()
+{
+    close();
+}
+
+bool OthelloPatterns::open(const std::string &path)
+{
+    close();
+    if (!_file.open(path)) {
+        return false;
+    }
+
+    // the file has to have been trained for exactly these shapes and stages
+    const Header *header = reinterpret_cast<const Header *>(_file.data());
+    if (_file.size() < sizeof(Header) || std::memcmp(header->magic, "OTPW", 4) != 0 || header->version != VERSION ||
+        header->stages != STAGES || header->stageSize != STAGE_SIZE ||
+        _file.size() < sizeof(Header) + (size_t)STAGES * STAGE_SIZE * sizeof(int16_t)) {
+        close();
+        return false;
+    }
+
+    _weights = reinterpret_cast<const int16_t *>(_file.data() + sizeof(Header));
+    return true;
+}
+
+void OthelloPatterns::close()
+{
+    _file.close();
+    _weights = nullptr;
+}
+
+int OthelloPatterns::shapeOf(int instance)
+{
+    return TABLES.shape[instance];
+}
+
+int OthelloPatterns::tableOffset(int instance)
+{
+    return TABLES.offset[instance];
+}
+
+int OthelloPatterns::evaluate(const Features &features, int discs) const
+{
+    const int16_t *weights = _weights + (size_t)stage(discs) * STAGE_SIZE;
+    int score = 0;
+    for (int i = 0; i < INSTANCES; i++) {
+        score += weights[TABLES.offset[i] + features.index[i]];
+    }
+    return score;
+}
+
+bool OthelloPatterns::write(const std::string &path, const std::vector<int16_t> &weights)
+{
+    if (weights.size() != (size_t)STAGES * STAGE_SIZE) {
+        return false;
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+
+    Header header;
+    std::memcpy(header.magic, "OTPW", 4);
+    header.version = VERSION;
+    header.stages = STAGES;
+    header.stageSize = STAGE_SIZE;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(weights.data()), weights.size() * sizeof(int16_t));
+    return (bool)file;
+}
+
+//
+// features
+//
+
+void OthelloPatterns::Features::set(uint64_t black, uint64_t white)
+{
+    for (int i = 0; i < INSTANCES; i++) {
+        int value = 0;
+        for (int k = TABLES.size[i] - 1; k >= 0; k--) {
+            int square = TABLES.squares[i][k];
+            int digit = ((black >> square) & 1) ? 1 : ((white >> square) & 1) ? 2 : 0;
+            value = value * 3 + digit;
+        }
+        index[i] = (uint16_t)value;
+    }
+}
+
+// a new disc adds its digit, a flipped one goes from the opponent's digit to ours
+void OthelloPatterns::Features::play(int square, uint64_t flipped, int player)
+{
+    int digit = (player == OthelloPosition::BLACK) ? 1 : 2;
+    for (int i = 0; i < TABLES.squareCount[square]; i++) {
+        index[TABLES.squareInstance[square][i]] += digit * TABLES.squarePower[square][i];
+    }
+
+    int change = (player == OthelloPosition::BLACK) ? -1 : 1;
+    for (; flipped; flipped &= flipped - 1) {
+        int flip = std::countr_zero(flipped);
+        for (int i = 0; i < TABLES.squareCount[flip]; i++) {
+            index[TABLES.squareInstance[flip][i]] += change * TABLES.squarePower[flip][i];
+        }
+    }
+}
+
+void OthelloPatterns::Features::undo(int square, uint64_t flipped, int player)
+{
+    int digit = (player == OthelloPosition::BLACK) ? 1 : 2;
+    for (int i = 0; i < TABLES.squareCount[square]; i++) {
+        index[TABLES.squareInstance[square][i]] -= digit * TABLES.squarePower[square][i];
+    }
+
+    int change = (player == OthelloPosition::BLACK) ? -1 : 1;
+    for (; flipped; flipped &= flipped - 1) {
+        int flip = std::countr_zero(flipped);
+        for (int i = 0; i < TABLES.squareCount[flip]; i++) {
+            index[TABLES.squareInstance[flip][i]] -= change * TABLES.squarePower[flip][i];
+        }
+    }
+}
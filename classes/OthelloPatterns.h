@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+//
+// othello evaluation by pattern tables
+//
+// the board is covered by 46 pattern instances: rows and columns 2-4 from the edge, the
+// diagonals of length 4 to 8, each edge with its two X squares, the 2x5 and 3x3 corner
+// blocks. every instance of a shape is the same square list under one of the board's 8
+// symmetries, so they all share one weight table, indexed by the base-3 number the squares
+// spell out (0 empty, 1 black, 2 white; the first square is the lowest digit).
+// the game is split into STAGES by disc count, each with its own set of tables, and the
+// evaluation is the sum of one table entry per instance, in hundredths of a disc from
+// black's point of view.
+//
+// the weights come from tools/othello_train.cpp and live in a binary file:
+//   header     magic "OTPW", version, stage count, weights per stage (4 x uint32)
+//   weights    int16 for every stage, shape and index, in that order
+// which is memory mapped, so any number of searches on any number of threads share one copy
+//
+class OthelloPatterns
+{
+public:
+    static const int SHAPES = 11;
+    static const int INSTANCES = 46;
+    static const int STAGES = 12;
+    static const int STAGE_SIZE = 167265;   // the table sizes of all the shapes, 3^squares each
+    static const int MAX_SQUARES = 10;      // the most squares in one shape
+
+    //
+    // the index of every instance, kept up to date move by move so evaluating is just the lookups
+    //
+    struct Features
+    {
+        uint16_t index[INSTANCES];
+
+        void    set(uint64_t black, uint64_t white);
+        // {player} played {square} and turned the {flipped} discs over
+        void    play(int square, uint64_t flipped, int player);
+        void    undo(int square, uint64_t flipped, int player);
+    };
+
+    OthelloPatterns();
+    ~OthelloPatterns();
+
+    // map a weights file, returns false (and stays closed) if it's missing or malformed
+    bool        open(const std::string &path);
+    void        close();
+    bool        isOpen() const { return _weights != nullptr; }
+
+    // hundredths of a disc from black's point of view, {discs} is how many are on the board
+    int         evaluate(const Features &features, int discs) const;
+
+    // write {STAGES} * {STAGE_SIZE} weights to a file
+    static bool write(const std::string &path, const std::vector<int16_t> &weights);
+
+    // layout of the weights, for the trainer
+    static int  stage(int discs) { return discs >= 64 ? STAGES - 1 : (discs - 4) / 5; }
+    static int  shapeOf(int instance);
+    static int  tableOffset(int instance);  // where the instance's shape starts within a stage
+
+    static constexpr const char *DEFAULT_FILE = "resources/othello_weights.bin";
+
+private:
+    struct Header
+    {
+        char     magic[4];
+        uint32_t version;
+        uint32_t stages;
+        uint32_t stageSize;
+    };
+
+    static const uint32_t VERSION = 1;
+
+    const int16_t *_weights;
+    MappedFile  _file;
+};
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <string>
+
+//
+// othello position on two 64-bit bitboards
+//
+// bit y * 8 + x is the square at x, y, the same order as the state string, so bit 0 is
+// the top left corner. legal moves and flips are computed for all eight directions at
+// once with Kogge-Stone fills: the side to move's discs are smeared across runs of
+// opponent discs in log2(8) = 3 shift-and-mask steps, with the edge masks keeping the
+// fills from wrapping around onto the next row.
+// header only so the move generator inlines into the search
+//
+class OthelloPosition
+{
+public:
+    static const int BLACK = 0;
+    static const int WHITE = 1;
+    static const int SQUARES = 64;
+
+    OthelloPosition() { reset(); }
+
+    // the four center discs, black to move
+    void        reset()
+    {
+        _boards[BLACK] = (1ULL << (4 * 8 + 3)) | (1ULL << (3 * 8 + 4));
+        _boards[WHITE] = (1ULL << (3 * 8 + 3)) | (1ULL << (4 * 8 + 4));
+        _playerToMove = BLACK;
+    }
+
+    // load an OthelloRules state string ('0' empty, '1' black, '2' white), false if it's malformed
+    bool        setState(const std::string &state, int playerToMove)
+    {
+        if (state.length() != SQUARES) return false;
+        uint64_t boards[2] = {0, 0};
+        for (int square = 0; square < SQUARES; square++) {
+            if (state[square] == '1') boards[BLACK] |= 1ULL << square;
+            else if (state[square] == '2') boards[WHITE] |= 1ULL << square;
+            else if (state[square] != '0') return false;
+        }
+        _boards[BLACK] = boards[BLACK];
+        _boards[WHITE] = boards[WHITE];
+        _playerToMove = playerToMove;
+        return true;
+    }
+
+    std::string state() const
+    {
+        std::string state(SQUARES, '0');
+        for (int square = 0; square < SQUARES; square++) {
+            if ((_boards[BLACK] >> square) & 1) state[square] = '1';
+            else if ((_boards[WHITE] >> square) & 1) state[square] = '2';
+        }
+        return state;
+    }
+
+    uint64_t    board(int player) const { return _boards[player]; }
+    uint64_t    current() const { return _boards[_playerToMove]; }
+    uint64_t    opponent() const { return _boards[_playerToMove ^ 1]; }
+    uint64_t    empties() const { return ~(_boards[BLACK] | _boards[WHITE]); }
+    int         playerToMove() const { return _playerToMove; }
+    int         discCount(int player) const { return std::popcount(_boards[player]); }
+    int         emptyCount() const { return std::popcount(empties()); }
+
+    // every square the side to move can play on
+    uint64_t    legalMoves() const { return legalMoves(current(), opponent()); }
+    bool        canPlay(int square) const { return (legalMoves() >> square) & 1; }
+
+    // the side to move has to pass, and neither side can move once the game is over
+    bool        mustPass() const { return legalMoves() == 0; }
+    bool        isGameOver() const { return legalMoves() == 0 && legalMoves(opponent(), current()) == 0; }
+
+    // play a legal move for the side to move, returns the discs it flipped for undo()
+    uint64_t    play(int square)
+    {
+        uint64_t move = 1ULL << square;
+        uint64_t flipped = flips(current(), opponent(), square);
+        _boards[_playerToMove] |= move | flipped;
+        _boards[_playerToMove ^ 1] &= ~flipped;
+        _playerToMove ^= 1;
+        return flipped;
+    }
+
+    void        undo(int square, uint64_t flipped)
+    {
+        _playerToMove ^= 1;
+        _boards[_playerToMove] &= ~((1ULL << square) | flipped);
+        _boards[_playerToMove ^ 1] |= flipped;
+    }
+
+    void        pass() { _playerToMove ^= 1; }
+
+    // the move that flips the most discs, ties go to the lowest square, -1 to pass
+    int         greedyMove() const
+    {
+        int bestMove = -1, maxFlips = 0;
+        for (uint64_t moves = legalMoves(); moves; moves &= moves - 1) {
+            int square = std::countr_zero(moves);
+            int count = std::popcount(flips(current(), opponent(), square));
+            if (count > maxFlips) {
+                maxFlips = count;
+                bestMove = square;
+            }
+        }
+        return bestMove;
+    }
+
+    //
+    // the move generator, on raw boards so a search can call it without a position
+    //
+    static uint64_t legalMoves(uint64_t player, uint64_t opponent)
+    {
+        uint64_t moves = movesAlong<1>(player, opponent & NOT_A_FILE) & NOT_A_FILE;    // E
+        moves |= movesAlong<-1>(player, opponent & NOT_H_FILE) & NOT_H_FILE;           // W
+        moves |= movesAlong<8>(player, opponent);                                      // S
+        moves |= movesAlong<-8>(player, opponent);                                     // N
+        moves |= movesAlong<9>(player, opponent & NOT_A_FILE) & NOT_A_FILE;            // SE
+        moves |= movesAlong<7>(player, opponent & NOT_H_FILE) & NOT_H_FILE;            // SW
+        moves |= movesAlong<-7>(player, opponent & NOT_A_FILE) & NOT_A_FILE;           // NE
+        moves |= movesAlong<-9>(player, opponent & NOT_H_FILE) & NOT_H_FILE;           // NW
+        return moves & ~(player | opponent);
+    }
+
+    // the opponent discs {player} would flip by playing at {square}, 0 if it isn't legal
+    static uint64_t flips(uint64_t player, uint64_t opponent, int square)
+    {
+        uint64_t move = 1ULL << square;
+        uint64_t flipped = flipsAlong<1>(move, player, opponent & NOT_A_FILE, NOT_A_FILE);
+        flipped |= flipsAlong<-1>(move, player, opponent & NOT_H_FILE, NOT_H_FILE);
+        flipped |= flipsAlong<8>(move, player, opponent, ~0ULL);
+        flipped |= flipsAlong<-8>(move, player, opponent, ~0ULL);
+        flipped |= flipsAlong<9>(move, player, opponent & NOT_A_FILE, NOT_A_FILE);
+        flipped |= flipsAlong<7>(move, player, opponent & NOT_H_FILE, NOT_H_FILE);
+        flipped |= flipsAlong<-7>(move, player, opponent & NOT_A_FILE, NOT_A_FILE);
+        flipped |= flipsAlong<-9>(move, player, opponent & NOT_H_FILE, NOT_H_FILE);
+        return flipped;
+    }
+
+private:
+    // a step east or west that wraps onto the next row lands on the far file, so the
+    // propagators and landing squares for those directions are masked with these
+    static constexpr uint64_t NOT_A_FILE = 0xfefefefefefefefeULL;
+    static constexpr uint64_t NOT_H_FILE = 0x7f7f7f7f7f7f7f7fULL;
+
+    // one step in a direction, positive is a left shift
+    template <int AMOUNT>
+    static uint64_t shift(uint64_t board)
+    {
+        if constexpr (AMOUNT > 0) return board << AMOUNT;
+        else return board >> -AMOUNT;
+    }
+
+    // Kogge-Stone occluded fill: {generator} smeared along {propagator} in one direction
+    template <int AMOUNT>
+    static uint64_t fill(uint64_t generator, uint64_t propagator)
+    {
+        generator |= propagator & shift<AMOUNT>(generator);
+        propagator &= shift<AMOUNT>(propagator);
+        generator |= propagator & shift<2 * AMOUNT>(generator);
+        propagator &= shift<2 * AMOUNT>(propagator);
+        generator |= propagator & shift<4 * AMOUNT>(generator);
+        return generator;
+    }
+
+    // squares one step past a run of opponent discs that starts next to one of ours.
+    // {opponent} is already masked for the direction, the caller masks the result
+    template <int AMOUNT>
+    static uint64_t movesAlong(uint64_t player, uint64_t opponent)
+    {
+        return shift<AMOUNT>(opponent & fill<AMOUNT>(player, opponent));
+    }
+
+    // the run of opponent discs from {move}, if one of ours closes it off
+    template <int AMOUNT>
+    static uint64_t flipsAlong(uint64_t move, uint64_t player, uint64_t opponent, uint64_t mask)
+    {
+        uint64_t run = opponent & fill<AMOUNT>(move, opponent);
+        return (shift<AMOUNT>(run) & mask & player) ? run : 0;
+    }
+
+    uint64_t    _boards[2];     // black, white
+    int         _playerToMove;
+};
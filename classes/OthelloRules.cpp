@@ -0,0 +1,89 @@
+#include "OthelloRules.h"
+
+const int OthelloRules::DIRECTIONS[8][2] = {
+    {0, -1}, {1, -1}, {1, 0}, {1, 1},
+    {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}
+};
+
+std::string OthelloRules::initialState()
+{
+    std::string state(64, EMPTY);
+    state[3 * 8 + 3] = WHITE;
+    state[4 * 8 + 4] = WHITE;
+    state[4 * 8 + 3] = BLACK;
+    state[3 * 8 + 4] = BLACK;
+    return state;
+}
+
+// how many opponent discs in a row from x, y in direction dx, dy end on one of ours
+static int flipsInDirection(const std::string &state, int x, int y, int dx, int dy, char piece)
+{
+    int nx = x + dx, ny = y + dy, count = 0;
+    while (nx >= 0 && nx < 8 && ny >= 0 && ny < 8) {
+        char c = state[ny * 8 + nx];
+        if (c == OthelloRules::EMPTY) return 0;
+        if (c == piece) return count;
+        count++;
+        nx += dx;
+        ny += dy;
+    }
+    return 0;   // ran off the board
+}
+
+int OthelloRules::countFlips(const std::string &state, int x, int y, char piece)
+{
+    if (state[y * 8 + x] != EMPTY) return 0;
+
+    int totalFlips = 0;
+    for (int i = 0; i < 8; i++) {
+        totalFlips += flipsInDirection(state, x, y, DIRECTIONS[i][0], DIRECTIONS[i][1], piece);
+    }
+    return totalFlips;
+}
+
+bool OthelloRules::hasValidMove(const std::string &state, char piece)
+{
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 8; x++) {
+            if (countFlips(state, x, y, piece) > 0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+int OthelloRules::playMove(std::string &state, int x, int y, char piece)
+{
+    if (state[y * 8 + x] != EMPTY) return 0;
+
+    int totalFlips = 0;
+    for (int i = 0; i < 8; i++) {
+        int dx = DIRECTIONS[i][0], dy = DIRECTIONS[i][1];
+        int count = flipsInDirection(state, x, y, dx, dy, piece);
+        for (int n = 1; n <= count; n++) {
+            state[(y + n * dy) * 8 + (x + n * dx)] = piece;
+        }
+        totalFlips += count;
+    }
+    if (totalFlips > 0) {
+        state[y * 8 + x] = piece;
+    }
+    return totalFlips;
+}
+
+// find move that flips the most pieces
+int OthelloRules::findGreedyMove(const std::string &state, char piece)
+{
+    int bestMove = -1, maxFlips = 0;
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 8; x++) {
+            int totalFlips = countFlips(state, x, y, piece);
+            if (totalFlips > maxFlips) {
+                maxFlips = totalFlips;
+                bestMove = y * 8 + x;
+            }
+        }
+    }
+    return bestMove;
+}
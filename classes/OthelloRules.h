@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+
+//
+// othello rules on a 64 character state string, independent of the gui
+//
+// the string uses the same layout as Othello::stateString(): index y * 8 + x,
+// '0' empty, '1' black, '2' white. black moves first
+//
+class OthelloRules
+{
+public:
+    static const char EMPTY = '0';
+    static const char BLACK = '1';
+    static const char WHITE = '2';
+
+    // the 8 directions: N, NE, E, SE, S, SW, W, NW
+    static const int DIRECTIONS[8][2];
+
+    static std::string initialState();
+    static char     opponent(char piece) { return piece == BLACK ? WHITE : BLACK; }
+
+    // how many discs {piece} would flip by playing at x, y, 0 if the move isn't legal
+    static int      countFlips(const std::string &state, int x, int y, char piece);
+    static bool     isValidMove(const std::string &state, int x, int y, char piece) { return countFlips(state, x, y, piece) > 0; }
+    static bool     hasValidMove(const std::string &state, char piece);
+
+    // place the disc and flip, returns the number flipped (0 and no change if it's not legal)
+    static int      playMove(std::string &state, int x, int y, char piece);
+
+    // the move that flips the most discs as a square index, -1 if {piece} has to pass
+    static int      findGreedyMove(const std::string &state, char piece);
+};
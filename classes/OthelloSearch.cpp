@@ -0,0 +1,580 @@
+#include <algorithm>
+#include <bit>
+#include "OthelloSearch.h"
+
+static const uint64_t NOT_A_FILE = 0xfefefefefefefefeULL;
+static const uint64_t NOT_H_FILE = 0x7f7f7f7f7f7f7f7fULL;
+static const uint64_t A_FILE = 0x0101010101010101ULL;
+static const uint64_t H_FILE = 0x8080808080808080ULL;
+static const uint64_t TOP_ROW = 0xffULL;
+static const uint64_t BOTTOM_ROW = 0xffULL << 56;
+
+static const uint64_t CORNERS = 0x8100000000000081ULL;
+static const uint64_t X_SQUARES = 0x0042000000004200ULL;   // diagonally next to a corner
+
+// evaluation weights
+static const int MOBILITY_WEIGHT = 10;
+static const int CORNER_WEIGHT = 40;
+static const int X_SQUARE_WEIGHT = 15;  // giving away the corner behind an X square
+static const int STABLE_WEIGHT = 10;
+static const int FRONTIER_WEIGHT = 4;
+
+// move ordering
+static const int ORDER_TT = 1 << 28;
+static const int ORDER_KILLER = 1 << 27;
+static const int HISTORY_MAX = 1 << 20;
+static const int ORDERING_MIN_DRAFT = 3;    // closer to the leaves the static order is cheaper overall
+
+// wider than any score the search can return, so a full window never fails
+static const int FULL_WINDOW = OthelloSearch::WINNING_SCORE * 2;
+
+// how good a square usually is, for ordering moves near the leaves
+static const int SQUARE_VALUES[64] = {
+    100, -20,  10,   5,   5,  10, -20, 100,
+    -20, -50,  -2,  -2,  -2,  -2, -50, -20,
+     10,  -2,  -1,  -1,  -1,  -1,  -2,  10,
+      5,  -2,  -1,  -1,  -1,  -1,  -2,   5,
+      5,  -2,  -1,  -1,  -1,  -1,  -2,   5,
+     10,  -2,  -1,  -1,  -1,  -1,  -2,  10,
+    -20, -50,  -2,  -2,  -2,  -2, -50, -20,
+    100, -20,  10,   5,   5,  10, -20, 100
+};
+
+//
+// the lines through every square along each axis: horizontal, vertical and both diagonals
+// a disc on a full line can't be flipped along that line
+//
+struct OthelloLines
+{
+    uint64_t lines[4][15];
+    int      count[4];
+
+    OthelloLines()
+    {
+        for (int axis = 0; axis < 4; axis++) {
+            count[axis] = 0;
+        }
+        for (int i = 0; i < 8; i++) {
+            lines[0][count[0]++] = TOP_ROW << (8 * i);
+            lines[1][count[1]++] = A_FILE << i;
+        }
+        // diagonals by x - y and by x + y
+        for (int d = -7; d <= 7; d++) {
+            uint64_t down = 0, up = 0;
+            for (int y = 0; y < 8; y++) {
+                int x = y + d;
+                if (x >= 0 && x < 8) down |= 1ULL << (y * 8 + x);
+                x = 7 - y + d;
+                if (x >= 0 && x < 8) up |= 1ULL << (y * 8 + x);
+            }
+            lines[2][count[2]++] = down;
+            lines[3][count[3]++] = up;
+        }
+    }
+
+    // squares whose line along {axis} is completely filled
+    uint64_t full(int axis, uint64_t filled) const
+    {
+        uint64_t result = 0;
+        for (int i = 0; i < count[axis]; i++) {
+            if ((filled & lines[axis][i]) == lines[axis][i]) {
+                result |= lines[axis][i];
+            }
+        }
+        return result;
+    }
+};
+
+static const OthelloLines LINES;
+
+OthelloSearch::OthelloSearch()
+{
+    _timeBudgetMs = SEARCH_TIME_MS;
+    _maxDepth = 60;
+    _endgameEmpties = ENDGAME_EMPTIES;
+    _patterns = nullptr;
+    _searchDepth = 0;
+    _canAbort = false;
+    _stop = false;
+    _cancel = nullptr;
+    _nodesSearched = 0;
+    _completedDepth = 0;
+    _bestScore = 0;
+}
+
+//
+// bitboard helpers
+//
+
+// the two boards are hashed separately, so the same discs with the other side to move get a different key
+static uint64_t mix(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+uint64_t OthelloSearch::positionKey(uint64_t player, uint64_t opponent)
+{
+    return mix(player) ^ mix(opponent + 0x9e3779b97f4a7c15ULL);
+}
+
+// every square next to a square in {board}
+uint64_t OthelloSearch::neighbors(uint64_t board)
+{
+    uint64_t sideways = ((board << 1) & NOT_A_FILE) | ((board >> 1) & NOT_H_FILE);
+    uint64_t row = board | sideways;
+    return sideways | (row << 8) | (row >> 8);
+}
+
+//
+// discs that can never be flipped again. along each of the four axes a disc is safe if
+// its line is full, or if the square on one side is off the board or holds one of our
+// stable discs. starting from nothing and repeating until no more discs qualify grows the
+// set out from the corners and full lines.
+// without a disc in any corner there's practically never a stable disc, so that's skipped
+//
+uint64_t OthelloSearch::stableDiscs(uint64_t player, uint64_t opponent)
+{
+    uint64_t filled = player | opponent;
+    if (!(filled & CORNERS)) return 0;
+
+    // off the board on one side of each axis: E/W, S/N, SE/NW, SW/NE
+    static const uint64_t edges[4] = {
+        A_FILE | H_FILE,
+        TOP_ROW | BOTTOM_ROW,
+        A_FILE | H_FILE | TOP_ROW | BOTTOM_ROW,
+        A_FILE | H_FILE | TOP_ROW | BOTTOM_ROW
+    };
+    static const int shifts[4] = {1, 8, 9, 7};
+
+    uint64_t safe[4];
+    for (int axis = 0; axis < 4; axis++) {
+        safe[axis] = edges[axis] | LINES.full(axis, filled);
+    }
+
+    uint64_t stable = 0;
+    for (;;) {
+        uint64_t next = player;
+        for (int axis = 0; axis < 4; axis++) {
+            // squares on the board edges are already safe, so the bits that wrap around don't matter
+            next &= safe[axis] | (stable >> shifts[axis]) | (stable << shifts[axis]);
+        }
+        if (next == stable) {
+            return stable;
+        }
+        stable = next;
+    }
+}
+
+int OthelloSearch::evaluate(uint64_t player, uint64_t opponent)
+{
+    uint64_t empty = ~(player | opponent);
+
+    int score = MOBILITY_WEIGHT * (std::popcount(OthelloPosition::legalMoves(player, opponent)) -
+                                   std::popcount(OthelloPosition::legalMoves(opponent, player)));
+    score += CORNER_WEIGHT * (std::popcount(player & CORNERS) - std::popcount(opponent & CORNERS));
+
+    // X squares only hurt while the corner next to them is still open
+    uint64_t riskyX = X_SQUARES & neighbors(CORNERS & empty);
+    score -= X_SQUARE_WEIGHT * (std::popcount(player & riskyX) - std::popcount(opponent & riskyX));
+
+    score += STABLE_WEIGHT * (std::popcount(stableDiscs(player, opponent)) -
+                              std::popcount(stableDiscs(opponent, player)));
+
+    // discs next to an empty square give the opponent something to flip
+    uint64_t frontier = neighbors(empty);
+    score -= FRONTIER_WEIGHT * (std::popcount(player & frontier) - std::popcount(opponent & frontier));
+
+    return std::clamp(score, 1 - EVAL_LIMIT, EVAL_LIMIT - 1);
+}
+
+// empty squares go to the winner, like in tournament scoring
+int OthelloSearch::finalScore(uint64_t player, uint64_t opponent)
+{
+    int mine = std::popcount(player);
+    int theirs = std::popcount(opponent);
+    int empties = 64 - mine - theirs;
+    if (mine > theirs) return WINNING_SCORE + mine - theirs + empties;
+    if (mine < theirs) return -WINNING_SCORE + mine - theirs - empties;
+    return 0;
+}
+
+// scores from the old evaluation don't mean anything to the new one, so the table starts over
+void OthelloSearch::setPatterns(const OthelloPatterns *patterns)
+{
+    _patterns = (patterns && patterns->isOpen()) ? patterns : nullptr;
+    _tt.clear();
+}
+
+//
+// search
+//
+
+int OthelloSearch::findBestMove(const OthelloPosition &position, const std::atomic<bool> *cancel, int timeBudgetMs)
+{
+    _position = position;
+    if (_patterns) {
+        _features.set(_position.board(OthelloPosition::BLACK), _position.board(OthelloPosition::WHITE));
+    }
+    _tt.newSearch();
+    _stop = false;
+    _cancel = cancel;
+    _canAbort = false;
+    _deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeBudgetMs > 0 ? timeBudgetMs : _timeBudgetMs);
+    _nodesSearched = 0;
+    _completedDepth = 0;
+    _bestScore = 0;
+    _principalVariation.clear();
+    std::fill(&_killers[0][0], &_killers[0][0] + MAX_PLY * 2, -1);
+    std::fill(&_history[0][0], &_history[0][0] + 2 * 64, 0);
+
+    uint64_t moves = _position.legalMoves();
+    if (!moves) {
+        return -1;
+    }
+
+    int rootOrder[32];
+    int rootCount = orderMoves(0, moves, -1, rootOrder);
+    int bestSquare = rootOrder[0];
+    if (rootCount == 1) {
+        _principalVariation.assign(1, bestSquare);
+        return bestSquare;  // nothing to think about
+    }
+
+    // the solver only knows its first move
+    if (_position.emptyCount() <= _endgameEmpties && solveEndgame(bestSquare)) {
+        _principalVariation.assign(1, bestSquare);
+        return bestSquare;
+    }
+
+    //
+    // iterative deepening: search one ply deeper each pass until the time budget runs out
+    // the best move of each pass is tried first on the next one, and an unfinished pass is thrown away
+    //
+    int lastDepth = std::min(_maxDepth, MAX_PLY - 1);
+    for (int depth = 1; depth <= lastDepth; depth++) {
+        _searchDepth = depth;
+
+        // aspiration window around the last score, a finished game is exact so it gets the full window
+        int alpha = -FULL_WINDOW;
+        int beta = FULL_WINDOW;
+        if (_completedDepth > 0 && std::abs(_bestScore) < WINNING_SCORE) {
+            alpha = _bestScore - ASPIRATION_WINDOW;
+            beta = _bestScore + ASPIRATION_WINDOW;
+        }
+
+        // widen whichever side the score fell out of until it lands inside
+        int score = 0;
+        int square = -1;
+        for (int delta = ASPIRATION_WINDOW * 4; ; delta *= 4) {
+            square = searchRoot(rootOrder, rootCount, alpha, beta, score);
+            if (_stop || square < 0) {
+                break;
+            }
+            if (score <= alpha && alpha > -FULL_WINDOW) {
+                alpha = std::max(score - delta, -FULL_WINDOW);
+            } else if (score >= beta && beta < FULL_WINDOW) {
+                beta = std::min(score + delta, FULL_WINDOW);
+            } else {
+                break;
+            }
+        }
+        if (_stop || square < 0) {
+            break;
+        }
+
+        bestSquare = square;
+        _bestScore = score;
+        _completedDepth = depth;
+        _canAbort = true;   // we have a move to fall back on now
+        _principalVariation.assign(_pv[0], _pv[0] + _pvLength[0]);
+
+        int *found = std::find(rootOrder, rootOrder + rootCount, square);
+        std::rotate(rootOrder, found, found + 1);
+
+        // a finished game can't get any better by looking deeper
+        if (std::abs(score) >= WINNING_SCORE || std::chrono::steady_clock::now() >= _deadline) {
+            break;
+        }
+    }
+    return bestSquare;
+}
+
+// play the rest of the game out exactly, false if the solver ran out of time and we have to search after all
+bool OthelloSearch::solveEndgame(int &bestSquare)
+{
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(_deadline - std::chrono::steady_clock::now());
+    _solver.setTimeBudget((int)std::max<int64_t>(remaining.count(), 1));
+    _solver.setCancelFlag(_cancel);
+
+    int score;
+    int square = _solver.bestMove(_position, score);
+    _nodesSearched += _solver.getNodesSearched();
+    if (score == OthelloSolver::UNKNOWN) {
+        return false;
+    }
+
+    // same scale as finalScore, so the result reads like a search that saw the end of the game
+    bestSquare = square;
+    _bestScore = score > 0 ? WINNING_SCORE + score : score < 0 ? -WINNING_SCORE + score : 0;
+    _completedDepth = _position.emptyCount();
+    return true;
+}
+
+//
+// search every root move to the current depth inside (alpha, beta), returns the best square.
+// a score at or below alpha is only an upper bound and one at or above beta only a lower
+// bound, and the caller widens the window and searches again
+//
+int OthelloSearch::searchRoot(int *rootOrder, int rootCount, int alpha, int beta, int &bestScore)
+{
+    int best = -FULL_WINDOW - 1;
+    int bestSquare = -1;
+
+    for (int i = 0; i < rootCount; i++) {
+        int square = rootOrder[i];
+        uint64_t flipped = playMove(square);
+        // the first move gets the whole window, the rest only have to show they're no better
+        int score;
+        if (i == 0) {
+            score = -negamax(1, -beta, -alpha);
+        } else {
+            score = -negamax(1, -alpha - 1, -alpha);
+            if (score > alpha && score < beta && !_stop) {
+                score = -negamax(1, -beta, -alpha);
+            }
+        }
+        undoMove(square, flipped);
+
+        if (_stop) {
+            return -1;
+        }
+        if (score > best) {
+            best = score;
+            bestSquare = square;
+            _pv[0][0] = square;
+            std::copy(_pv[1], _pv[1] + _pvLength[1], _pv[0] + 1);
+            _pvLength[0] = _pvLength[1] + 1;
+        }
+        alpha = std::max(alpha, score);
+        if (alpha >= beta) {
+            break;  // fails high, the caller searches again with a wider window
+        }
+    }
+
+    bestScore = best;
+    return bestSquare;
+}
+
+// moves in the search go through here, so the pattern indices stay in step with the board
+uint64_t OthelloSearch::playMove(int square)
+{
+    int player = _position.playerToMove();
+    uint64_t flipped = _position.play(square);
+    if (_patterns) {
+        _features.play(square, flipped, player);
+    }
+    return flipped;
+}
+
+void OthelloSearch::undoMove(int square, uint64_t flipped)
+{
+    _position.undo(square, flipped);
+    if (_patterns) {
+        _features.undo(square, flipped, _position.playerToMove());
+    }
+}
+
+// the pattern tables score for black, the search wants the side to move
+int OthelloSearch::evaluatePosition()
+{
+    if (!_patterns) {
+        return evaluate(_position.current(), _position.opponent());
+    }
+    int score = _patterns->evaluate(_features, OthelloPosition::SQUARES - _position.emptyCount());
+    if (_position.playerToMove() == OthelloPosition::WHITE) {
+        score = -score;
+    }
+    return std::clamp(score, 1 - EVAL_LIMIT, EVAL_LIMIT - 1);
+}
+
+// only the clock and the cancel flag stop a search, and only after one pass has finished
+bool OthelloSearch::shouldStop()
+{
+    if (_stop) {
+        return true;
+    }
+    // poll the clock every few thousand nodes, not on every one
+    if ((++_nodesSearched & 4095) == 0) {
+        if ((_cancel && _cancel->load()) ||
+            (_canAbort && std::chrono::steady_clock::now() >= _deadline)) {
+            _stop = true;
+        }
+    }
+    return _stop;
+}
+
+// scores are from the point of view of the side to move in _position
+int OthelloSearch::negamax(int depth, int alpha, int beta)
+{
+    _pvLength[depth] = 0;
+    if (shouldStop()) return 0;    // out of time, this result is meaningless
+
+    uint64_t player = _position.current();
+    uint64_t opponent = _position.opponent();
+    uint64_t moves = OthelloPosition::legalMoves(player, opponent);
+
+    if (!moves) {
+        // both sides stuck is the end of the game, otherwise pass
+        if (!OthelloPosition::legalMoves(opponent, player)) {
+            return finalScore(player, opponent);
+        }
+        if (depth >= _searchDepth || depth >= MAX_PLY - 1) {
+            return evaluatePosition();
+        }
+        _position.pass();
+        int score = -negamax(depth + 1, -beta, -alpha);
+        _position.pass();
+        _pv[depth][0] = -1;
+        std::copy(_pv[depth + 1], _pv[depth + 1] + _pvLength[depth + 1], _pv[depth] + 1);
+        _pvLength[depth] = _pvLength[depth + 1] + 1;
+        return score;
+    }
+
+    if (depth >= _searchDepth) {
+        return evaluatePosition();
+    }
+
+    // transposition table lookup. nodes inside a full window keep searching whatever the
+    // table says, so the principal variation comes out whole
+    int alphaOrig = alpha;
+    bool pvNode = beta - alpha > 1;
+    int draft = _searchDepth - depth;
+    int ttMove = -1;
+    uint64_t key = positionKey(player, opponent);
+    TranspositionTable::Entry entry;
+    if (_tt.probe(key, entry)) {
+        ttMove = entry.move;
+        if (!pvNode && entry.depth >= draft) {
+            if (entry.bound == TranspositionTable::BOUND_EXACT) return entry.score;
+            if (entry.bound == TranspositionTable::BOUND_LOWER) alpha = std::max(alpha, (int)entry.score);
+            if (entry.bound == TranspositionTable::BOUND_UPPER) beta = std::min(beta, (int)entry.score);
+            if (alpha >= beta) return entry.score;
+        }
+    }
+
+    int bestValue = -WINNING_SCORE * 2;
+    int bestSquare = -1;
+
+    int ordered[32];
+    int count = orderMoves(depth, moves, ttMove, ordered);
+    for (int i = 0; i < count; i++) {
+        int square = ordered[i];
+        uint64_t flipped = playMove(square);
+        int newValue;
+        if (i == 0) {
+            newValue = -negamax(depth + 1, -beta, -alpha);
+        } else {
+            // principal variation search: a null window proves the move is no better, and
+            // only a move that beats alpha gets searched again with the full window
+            newValue = -negamax(depth + 1, -alpha - 1, -alpha);
+            if (newValue > alpha && newValue < beta && !_stop) {
+                newValue = -negamax(depth + 1, -beta, -alpha);
+            }
+        }
+        undoMove(square, flipped);
+
+        if (_stop) return 0;
+
+        if (newValue > bestValue) {
+            bestValue = newValue;
+            bestSquare = square;
+            if (pvNode && newValue > alpha) {
+                _pv[depth][0] = square;
+                std::copy(_pv[depth + 1], _pv[depth + 1] + _pvLength[depth + 1], _pv[depth] + 1);
+                _pvLength[depth] = _pvLength[depth + 1] + 1;
+            }
+        }
+        alpha = std::max(alpha, newValue);
+
+        if (alpha >= beta) {    // prune
+            updateOrdering(depth, square, draft);
+            break;
+        }
+    }
+
+    TranspositionTable::Bound bound = TranspositionTable::BOUND_EXACT;
+    if (bestValue <= alphaOrig) bound = TranspositionTable::BOUND_UPPER;
+    else if (bestValue >= beta) bound = TranspositionTable::BOUND_LOWER;
+    _tt.store(key, bestValue, bestSquare, draft, bound);
+
+    return bestValue;
+}
+
+//
+// order the legal moves at this node, best first, returns how many there are
+//
+// the table's move comes first, then this ply's killers, then the rest by history and by how
+// few replies they leave the opponent. near the leaves that costs more than it saves, so
+// those nodes just put the table's move in front and sort the rest by square value
+//
+int OthelloSearch::orderMoves(int depth, uint64_t moves, int ttMove, int *ordered)
+{
+    uint64_t player = _position.current();
+    uint64_t opponent = _position.opponent();
+    bool dynamic = _searchDepth - depth >= ORDERING_MIN_DRAFT;
+    const int *history = _history[_position.playerToMove()];
+
+    int scores[32];
+    int count = 0;
+    for (; moves; moves &= moves - 1) {
+        int square = std::countr_zero(moves);
+        int score;
+        if (square == ttMove) {
+            score = ORDER_TT;
+        } else if (!dynamic) {
+            score = SQUARE_VALUES[square];
+        } else if (square == _killers[depth][0]) {
+            score = ORDER_KILLER + 1;
+        } else if (square == _killers[depth][1]) {
+            score = ORDER_KILLER;
+        } else {
+            uint64_t move = 1ULL << square;
+            uint64_t flipped = OthelloPosition::flips(player, opponent, square);
+            int replies = std::popcount(OthelloPosition::legalMoves(opponent & ~flipped, player | move | flipped));
+            score = history[square] * 8 + SQUARE_VALUES[square] - 16 * replies;
+        }
+
+        // insertion sort, there are rarely more than a dozen moves
+        int i = count++;
+        while (i > 0 && scores[i - 1] < score) {
+            scores[i] = scores[i - 1];
+            ordered[i] = ordered[i - 1];
+            i--;
+        }
+        scores[i] = score;
+        ordered[i] = square;
+    }
+    return count;
+}
+
+// a move that caused a cutoff becomes a killer for this ply and earns history
+void OthelloSearch::updateOrdering(int depth, int square, int draft)
+{
+    if (_killers[depth][0] != square) {
+        _killers[depth][1] = _killers[depth][0];
+        _killers[depth][0] = square;
+    }
+
+    int *history = _history[_position.playerToMove()];
+    history[square] += draft * draft;
+    if (history[square] > HISTORY_MAX) {
+        for (int i = 0; i < 64; i++) {
+            history[i] /= 2;
+        }
+    }
+}
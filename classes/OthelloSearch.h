@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include "OthelloPosition.h"
+#include "TranspositionTable.h"
+#include "OthelloSolver.h"
+#include "OthelloPatterns.h"
+
+//
+// othello search engine, independent of the gui so it can run on a worker thread
+//
+// negamax with alpha-beta and iterative deepening on an OthelloPosition, with a
+// transposition table, killer and history move ordering and a time budget. positions are
+// scored by the pattern tables when it's given a set, and by a handful of hand-tuned terms
+// (mobility, corners, stability, frontier) when it isn't. a side with
+// no legal move passes, which counts as a ply, and the game is over once both sides
+// have to pass.
+// finished games score the final disc difference on top of WINNING_SCORE, which doesn't
+// depend on how far from the root they are, so the table is kept from one move to the next.
+// once few enough squares are left the endgame solver plays the rest out exactly instead
+//
+// every node is a principal variation search: the first move gets the full window and the
+// rest a null window that only proves they're no better, with a full re-search when that
+// fails. each pass of iterative deepening starts from a narrow aspiration window around the
+// score of the pass before and widens it when the score falls outside
+//
+class OthelloSearch
+{
+public:
+    OthelloSearch();
+
+    // pick a square for the side to move, -1 if it has to pass
+    // {timeBudgetMs} overrides setTimeBudget() for this search only, 0 keeps it
+    int         findBestMove(const OthelloPosition &position, const std::atomic<bool> *cancel = nullptr, int timeBudgetMs = 0);
+
+    // settings
+    void        setTimeBudget(int milliseconds) { _timeBudgetMs = milliseconds; }
+    int         getTimeBudget() const { return _timeBudgetMs; }
+    void        setMaxDepth(int depth) { _maxDepth = depth; }
+    // solve exactly at this many empty squares or fewer, 0 to always search
+    void        setEndgameEmpties(int empties) { _endgameEmpties = empties; }
+    // evaluate with these pattern weights, which have to outlive the search. nullptr or a
+    // closed set goes back to the hand-tuned evaluation
+    void        setPatterns(const OthelloPatterns *patterns);
+    void        setTranspositionTableSize(size_t megabytes) { _tt.resize(megabytes); }
+    // wipe the table, so a search doesn't depend on the ones before it
+    void        clearTranspositionTable() { _tt.clear(); }
+
+    // statistics from the last search
+    uint64_t    getNodesSearched() const { return _nodesSearched; }
+    int         getCompletedDepth() const { return _completedDepth; }
+    int         getBestScore() const { return _bestScore; }
+    // the line the search expects, starting with its move, as squares with -1 for a pass
+    const std::vector<int> &getPrincipalVariation() const { return _principalVariation; }
+
+    // bitboard helpers
+    static uint64_t positionKey(uint64_t player, uint64_t opponent);
+    static uint64_t stableDiscs(uint64_t player, uint64_t opponent);
+    static uint64_t neighbors(uint64_t board);
+
+    // hand-tuned evaluation from {player}'s point of view: mobility, corners, stability and frontier
+    static int      evaluate(uint64_t player, uint64_t opponent);
+    // score of a finished game from {player}'s point of view
+    static int      finalScore(uint64_t player, uint64_t opponent);
+
+    static const int WINNING_SCORE = 10000;
+    static const int SEARCH_TIME_MS = 500;  // default time budget for one AI move
+    static const int EVAL_LIMIT = 5000;     // evaluate stays inside this, below any finished game
+    static const int MAX_PLY = 128;         // deep enough for 60 moves and their passes
+    static const int ENDGAME_EMPTIES = 16;  // the solver finishes these well inside SEARCH_TIME_MS
+    static const int ASPIRATION_WINDOW = 20;    // each side of the last pass's score
+
+private:
+    bool        solveEndgame(int &bestSquare);
+    int         searchRoot(int *rootOrder, int rootCount, int alpha, int beta, int &bestScore);
+    int         negamax(int depth, int alpha, int beta);
+    int         evaluatePosition();
+    uint64_t    playMove(int square);
+    void        undoMove(int square, uint64_t flipped);
+    int         orderMoves(int depth, uint64_t moves, int ttMove, int *ordered);
+    void        updateOrdering(int depth, int square, int draft);
+    bool        shouldStop();
+
+    TranspositionTable _tt;
+    int         _timeBudgetMs;
+    int         _maxDepth;
+    int         _endgameEmpties;
+    OthelloSolver _solver;
+    const OthelloPatterns *_patterns;
+
+    // state of the running search
+    OthelloPosition _position;      // played forward and back as the search goes
+    OthelloPatterns::Features _features;    // follows _position when there are patterns
+    int         _searchDepth;       // depth of the current iterative deepening pass
+    bool        _canAbort;          // only abort once one pass has finished
+    bool        _stop;
+    const std::atomic<bool> *_cancel;
+    std::chrono::steady_clock::time_point _deadline;
+    int         _killers[MAX_PLY][2];   // last two moves that caused a cutoff at each ply
+    int         _history[2][64];        // cutoff counts by side to move and square
+    // the best line below each ply of the running pass, _pv[depth][0] is the move at depth
+    int         _pv[MAX_PLY][MAX_PLY];
+    int         _pvLength[MAX_PLY];
+
+    uint64_t    _nodesSearched;
+    int         _completedDepth;
+    int         _bestScore;
+    std::vector<int> _principalVariation;
+};
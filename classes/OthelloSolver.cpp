@@ -0,0 +1,320 @@
+#include <algorithm>
+#include <bit>
+#include "OthelloSolver.h"
+#include "OthelloSearch.h"
+
+// the four 4x4 quadrants, for parity
+static const uint64_t QUADRANTS[4] = {
+    0x000000000f0f0f0fULL,
+    0x00000000f0f0f0f0ULL,
+    0x0f0f0f0f00000000ULL,
+    0xf0f0f0f000000000ULL
+};
+
+static const uint64_t CORNERS = 0x8100000000000081ULL;
+
+// empty squares in quadrants that have an odd number of them
+static uint64_t oddQuadrants(uint64_t empty)
+{
+    uint64_t odd = 0;
+    for (uint64_t quadrant : QUADRANTS) {
+        if (std::popcount(empty & quadrant) & 1) {
+            odd |= empty & quadrant;
+        }
+    }
+    return odd;
+}
+
+OthelloSolver::OthelloSolver() : _tt(TT_MEGABYTES)
+{
+    _nodesSearched = 0;
+    _nextCheck = 0;
+    _timeBudgetMs = 24 * 60 * 60 * 1000;
+    _aborted = false;
+    _cancel = nullptr;
+}
+
+int OthelloSolver::finalScore(uint64_t player, uint64_t opponent)
+{
+    int diff = std::popcount(player) - std::popcount(opponent);
+    int empties = 64 - std::popcount(player | opponent);
+    if (diff > 0) return diff + empties;
+    if (diff < 0) return diff - empties;
+    return 0;
+}
+
+// poll the clock every few thousand nodes, not on every one
+bool OthelloSolver::timeUp()
+{
+    if (!_aborted && _nodesSearched >= _nextCheck) {
+        _nextCheck = _nodesSearched + 4096;
+        _aborted = (_cancel && _cancel->load()) || std::chrono::steady_clock::now() >= _deadline;
+    }
+    return _aborted;
+}
+
+//
+// the last few empties: try each square straight from the list, no move generation.
+// a side that can't play any of them passes, and if neither can the game is over
+//
+
+// one empty square: whoever can play it does, the score follows from the flip count alone
+template <>
+int OthelloSolver::solveLast<1>(uint64_t player, uint64_t opponent, int alpha, int beta, const int *squares, bool passed)
+{
+    _nodesSearched++;
+    int diff = 2 * std::popcount(player) - 63;     // player - opponent, with 63 discs down
+
+    int flips = std::popcount(OthelloPosition::flips(player, opponent, squares[0]));
+    if (flips) {
+        return diff + 2 * flips + 1;
+    }
+    flips = std::popcount(OthelloPosition::flips(opponent, player, squares[0]));
+    if (flips) {
+        return diff - 2 * flips - 1;
+    }
+    return diff > 0 ? diff + 1 : diff - 1;          // nobody can play, the last square goes to the winner
+}
+
+template <int EMPTIES>
+int OthelloSolver::solveLast(uint64_t player, uint64_t opponent, int alpha, int beta, const int *squares, bool passed)
+{
+    _nodesSearched++;
+    int best = -65;
+    int rest[EMPTIES - 1];
+
+    for (int i = 0; i < EMPTIES; i++) {
+        int square = squares[i];
+        uint64_t flipped = OthelloPosition::flips(player, opponent, square);
+        if (!flipped) continue;
+
+        // the other squares, in the same order
+        for (int j = 0, k = 0; j < EMPTIES; j++) {
+            if (j != i) rest[k++] = squares[j];
+        }
+        uint64_t move = 1ULL << square;
+        int score = -solveLast<EMPTIES - 1>(opponent & ~flipped, player | move | flipped, -beta, -std::max(alpha, best), rest, false);
+        if (score > best) {
+            best = score;
+            if (best >= beta) return best;
+        }
+    }
+
+    if (best == -65) {
+        if (passed) return finalScore(player, opponent);
+        return -solveLast<EMPTIES>(opponent, player, -beta, -alpha, squares, true);
+    }
+    return best;
+}
+
+// entry to the last-4 routines: list the empties, odd quadrants first
+int OthelloSolver::solveLast4(uint64_t player, uint64_t opponent, int alpha, int beta)
+{
+    uint64_t empty = ~(player | opponent);
+    uint64_t odd = oddQuadrants(empty);
+
+    int squares[4];
+    int count = 0;
+    for (uint64_t group : {empty & odd, empty & ~odd}) {
+        for (; group; group &= group - 1) {
+            squares[count++] = std::countr_zero(group);
+        }
+    }
+
+    switch (count) {
+        case 0: return finalScore(player, opponent);
+        case 1: return solveLast<1>(player, opponent, alpha, beta, squares, false);
+        case 2: return solveLast<2>(player, opponent, alpha, beta, squares, false);
+        case 3: return solveLast<3>(player, opponent, alpha, beta, squares, false);
+        default: return solveLast<4>(player, opponent, alpha, beta, squares, false);
+    }
+}
+
+//
+// order the moves at a node, returns how many there are
+//
+int OthelloSolver::orderMoves(uint64_t player, uint64_t opponent, uint64_t moves, int ttMove, int *ordered)
+{
+    uint64_t empty = ~(player | opponent);
+    int empties = std::popcount(empty);
+    int count = 0;
+
+    if (empties <= FASTEST_FIRST_EMPTIES) {
+        // parity: odd quadrants first, the table's move ahead of everything
+        if (ttMove >= 0 && ((moves >> ttMove) & 1)) {
+            ordered[count++] = ttMove;
+            moves &= ~(1ULL << ttMove);
+        }
+        uint64_t odd = oddQuadrants(empty);
+        for (uint64_t group : {moves & odd, moves & ~odd}) {
+            for (; group; group &= group - 1) {
+                ordered[count++] = std::countr_zero(group);
+            }
+        }
+        return count;
+    }
+
+    // fastest first: fewest replies for the opponent, corners break ties
+    int scores[32];
+    for (; moves; moves &= moves - 1) {
+        int square = std::countr_zero(moves);
+        uint64_t move = 1ULL << square;
+        int score;
+        if (square == ttMove) {
+            score = 1 << 20;
+        } else {
+            uint64_t flipped = OthelloPosition::flips(player, opponent, square);
+            uint64_t replies = OthelloPosition::legalMoves(opponent & ~flipped, player | move | flipped);
+            score = -16 * (std::popcount(replies) + std::popcount(replies & CORNERS)) + ((move & CORNERS) ? 8 : 0);
+        }
+
+        int i = count++;
+        while (i > 0 && scores[i - 1] < score) {
+            scores[i] = scores[i - 1];
+            ordered[i] = ordered[i - 1];
+            i--;
+        }
+        scores[i] = score;
+        ordered[i] = square;
+    }
+    return count;
+}
+
+//
+// principal variation search: the first move gets the full window, the rest only have to
+// prove they're no better, and get searched again if they are
+//
+int OthelloSolver::negamax(uint64_t player, uint64_t opponent, int alpha, int beta, bool passed)
+{
+    _nodesSearched++;
+    if (timeUp()) return 0;    // the caller throws this away
+
+    int empties = 64 - std::popcount(player | opponent);
+    if (empties <= 4) {
+        return solveLast4(player, opponent, alpha, beta);
+    }
+
+    uint64_t moves = OthelloPosition::legalMoves(player, opponent);
+    if (!moves) {
+        if (passed) return finalScore(player, opponent);
+        return -negamax(opponent, player, -beta, -alpha, true);
+    }
+
+    int alphaOrig = alpha;
+    int ttMove = -1;
+    uint64_t key = 0;
+    if (empties >= TT_MIN_EMPTIES) {
+        key = OthelloSearch::positionKey(player, opponent);
+        TranspositionTable::Entry entry;
+        if (_tt.probe(key, entry)) {
+            ttMove = entry.move;
+            if (entry.bound == TranspositionTable::BOUND_EXACT) return entry.score;
+            if (entry.bound == TranspositionTable::BOUND_LOWER) alpha = std::max(alpha, (int)entry.score);
+            if (entry.bound == TranspositionTable::BOUND_UPPER) beta = std::min(beta, (int)entry.score);
+            if (alpha >= beta) return entry.score;
+        }
+    }
+
+    int ordered[32];
+    int count = orderMoves(player, opponent, moves, ttMove, ordered);
+    int best = -65;
+    int bestSquare = -1;
+    for (int i = 0; i < count; i++) {
+        int square = ordered[i];
+        uint64_t move = 1ULL << square;
+        uint64_t flipped = OthelloPosition::flips(player, opponent, square);
+        uint64_t nextPlayer = opponent & ~flipped;
+        uint64_t nextOpponent = player | move | flipped;
+
+        int score;
+        if (i == 0) {
+            score = -negamax(nextPlayer, nextOpponent, -beta, -alpha, false);
+        } else {
+            score = -negamax(nextPlayer, nextOpponent, -alpha - 1, -alpha, false);
+            if (score > alpha && score < beta) {
+                score = -negamax(nextPlayer, nextOpponent, -beta, -alpha, false);
+            }
+        }
+        if (_aborted) return 0;
+
+        if (score > best) {
+            best = score;
+            bestSquare = square;
+            alpha = std::max(alpha, score);
+            if (alpha >= beta) break;
+        }
+    }
+
+    if (empties >= TT_MIN_EMPTIES) {
+        TranspositionTable::Bound bound = TranspositionTable::BOUND_EXACT;
+        if (best <= alphaOrig) bound = TranspositionTable::BOUND_UPPER;
+        else if (best >= beta) bound = TranspositionTable::BOUND_LOWER;
+        _tt.store(key, best, bestSquare, empties, bound);
+    }
+    return best;
+}
+
+int OthelloSolver::solve(uint64_t player, uint64_t opponent)
+{
+    _nodesSearched = 0;
+    _nextCheck = 0;
+    _aborted = false;
+    _deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(_timeBudgetMs);
+    _tt.newSearch();
+
+    int score = negamax(player, opponent, -64, 64, false);
+    return _aborted ? UNKNOWN : score;
+}
+
+int OthelloSolver::bestMove(const OthelloPosition &position, int &score)
+{
+    uint64_t player = position.current();
+    uint64_t opponent = position.opponent();
+
+    _nodesSearched = 0;
+    _nextCheck = 0;
+    _aborted = false;
+    _deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(_timeBudgetMs);
+    _tt.newSearch();
+
+    uint64_t moves = position.legalMoves();
+    if (!moves) {
+        score = solve(player, opponent);
+        return -1;
+    }
+
+    // the root is a regular node, but it has to keep track of which move got the score
+    int ordered[32];
+    int count = orderMoves(player, opponent, moves, -1, ordered);
+    int alpha = -64;
+    int bestSquare = ordered[0];
+    score = -65;
+    for (int i = 0; i < count; i++) {
+        int square = ordered[i];
+        uint64_t move = 1ULL << square;
+        uint64_t flipped = OthelloPosition::flips(player, opponent, square);
+        uint64_t nextPlayer = opponent & ~flipped;
+        uint64_t nextOpponent = player | move | flipped;
+
+        int childScore;
+        if (i == 0) {
+            childScore = -negamax(nextPlayer, nextOpponent, -64, 64, false);
+        } else {
+            childScore = -negamax(nextPlayer, nextOpponent, -alpha - 1, -alpha, false);
+            if (childScore > alpha) {
+                childScore = -negamax(nextPlayer, nextOpponent, -64, -alpha, false);
+            }
+        }
+        if (_aborted) {
+            score = UNKNOWN;
+            return -1;
+        }
+
+        if (childScore > score) {
+            score = childScore;
+            bestSquare = square;
+            alpha = std::max(alpha, score);
+        }
+    }
+    return bestSquare;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include "OthelloPosition.h"
+#include "TranspositionTable.h"
+
+//
+// exact othello endgame solver
+//
+// plays every line out to the end and returns the final disc difference, with the
+// empty squares going to the winner. the order moves are tried in changes with the
+// number of empties:
+//   above FASTEST_FIRST_EMPTIES   fastest first: the moves that leave the opponent the fewest replies
+//   below that                    parity: moves into quadrants with an odd number of empties first,
+//                                 so we tend to get the last move in each region
+//   the last 4                    dedicated routines over the empty squares themselves, with
+//                                 no move generation and no table
+//
+// scores are from the point of view of the side to move, -64 .. 64
+//
+class OthelloSolver
+{
+public:
+    OthelloSolver();
+
+    // exact score of the position for {player}, UNKNOWN if the time budget or cancel flag stopped it
+    int         solve(uint64_t player, uint64_t opponent);
+
+    // best square for the side to move and its exact score, -1 to pass.
+    // {score} is UNKNOWN and the move is -1 if it ran out of time
+    int         bestMove(const OthelloPosition &position, int &score);
+
+    // settings
+    void        setTimeBudget(int milliseconds) { _timeBudgetMs = milliseconds; }
+    void        setCancelFlag(const std::atomic<bool> *cancel) { _cancel = cancel; }
+    void        setTranspositionTableSize(size_t megabytes) { _tt.resize(megabytes); }
+    void        reset() { _tt.clear(); }
+
+    uint64_t    getNodesSearched() const { return _nodesSearched; }
+
+    static int  finalScore(uint64_t player, uint64_t opponent);
+
+    static const int UNKNOWN = -1000;
+    static const int TT_MEGABYTES = 32;
+    static const int FASTEST_FIRST_EMPTIES = 7;
+    static const int TT_MIN_EMPTIES = 8;    // shallower than this the table costs more than it saves
+
+private:
+    int         negamax(uint64_t player, uint64_t opponent, int alpha, int beta, bool passed);
+    int         orderMoves(uint64_t player, uint64_t opponent, uint64_t moves, int ttMove, int *ordered);
+    int         solveLast4(uint64_t player, uint64_t opponent, int alpha, int beta);
+    bool        timeUp();
+
+    template <int EMPTIES>
+    int         solveLast(uint64_t player, uint64_t opponent, int alpha, int beta, const int *squares, bool passed);
+
+    TranspositionTable _tt;
+    uint64_t    _nodesSearched;
+    uint64_t    _nextCheck;         // node count at which to look at the clock again
+    int         _timeBudgetMs;
+    bool        _aborted;
+    const std::atomic<bool> *_cancel;
+    std::chrono::steady_clock::time_point _deadline;
+};
@@ -0,0 +1,446 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <vector>
+#include "TranspositionTable.h"
+
+//
+// what a game has to supply to be searched by Search<Position>
+//
+// Move is whatever the game needs to play and take back a move; play() may fill in the
+// details undo() needs. generate() lists the legal moves of a position that isn't terminal,
+// there has to be at least one (a pass is a move). terminal() says whether the game is over,
+// and if so sets {margin} to the result for the side to move: positive for a win, negative
+// for a loss, 0 for a draw, its size a tie-break of at most MAX_MARGIN (a disc count, say).
+// evaluate() scores a position that isn't over from the side to move's point of view.
+// moveId() gives each move a number below MOVE_IDS for the killer and history tables.
+//
+// optional extras the search picks up when the position has them:
+//   int  orderHint(const Move &) const   a static ordering score, higher is tried first
+//   bool forcing() const                 the side to move can't stand pat (a capture is
+//                                        forced, say), so a leaf is searched on until it isn't
+//   bool lookup(int &score) const        the position's value is known without searching it
+//                                        (from an endgame database, say). {score} is from the
+//                                        side to move's point of view, above any evaluation and
+//                                        below any finished game. asked at every node past the root
+//   void prepareRoot(std::vector<Move> &) called once with the root's moves before the search,
+//                                        it may drop the ones it knows are worse as long as one
+//                                        is left, and set up whatever lookup() needs
+//
+template <typename Position>
+concept SearchPosition = std::default_initializable<Position> && std::copyable<Position> &&
+    requires(Position position, const Position constPosition, typename Position::Move move,
+             std::vector<typename Position::Move> moves, int margin) {
+    { Position::MOVE_IDS } -> std::convertible_to<int>;
+    constPosition.generate(moves);
+    position.play(move);
+    position.undo(move);
+    { constPosition.key() } -> std::convertible_to<uint64_t>;
+    { constPosition.evaluate() } -> std::convertible_to<int>;
+    { constPosition.terminal(margin) } -> std::convertible_to<bool>;
+    { constPosition.moveId(move) } -> std::convertible_to<int>;
+    { constPosition.playerToMove() } -> std::convertible_to<int>;
+};
+
+//
+// generic game search: negamax with alpha-beta, principal variation search, iterative
+// deepening, a transposition table, killer and history move ordering and a time budget
+//
+// it knows nothing about any game, everything goes through the Position type, which is a
+// template parameter rather than an interface so every call inlines into the search for
+// each game. finished games score WINNING_SCORE plus the margin less the ply they happen
+// at, so the search goes for the quickest win and holds out longest in a lost position,
+// and the table stores them relative to the node so they stay right from any ply.
+// moves are identified by their index in the list generate() makes.
+// header only, it's a template
+//
+template <SearchPosition Position>
+class Search
+{
+public:
+    typedef typename Position::Move Move;
+
+    static constexpr int WINNING_SCORE = 10000;
+    static constexpr int MAX_MARGIN = 100;
+    static constexpr int EVAL_LIMIT = 5000;     // evaluations are clamped inside this
+    static constexpr int MAX_PLY = 128;
+    static constexpr int RESULT_BOUND = WINNING_SCORE - MAX_MARGIN - MAX_PLY;  // anything past this is a finished game
+    static constexpr int SEARCH_TIME_MS = 500;  // default time budget for one AI move
+    static constexpr int MAX_MOVES = 127;       // the table stores moves in a signed byte
+
+    Search()
+    {
+        _timeBudgetMs = SEARCH_TIME_MS;
+        _maxDepth = MAX_PLY - 1;
+        _stop = false;
+        _canAbort = false;
+        _cancel = nullptr;
+        _nodesSearched = 0;
+        _completedDepth = 0;
+        _bestScore = 0;
+        for (std::vector<int> &history : _history) {
+            history.resize(Position::MOVE_IDS);
+        }
+    }
+
+    // pick a move for the side to move, false if the game is over
+    bool        findBestMove(const Position &position, Move &bestMove, const std::atomic<bool> *cancel = nullptr);
+
+    // settings
+    void        setTimeBudget(int milliseconds) { _timeBudgetMs = milliseconds; }
+    void        setMaxDepth(int depth) { _maxDepth = std::clamp(depth, 1, MAX_PLY - 1); }
+    void        setTranspositionTableSize(size_t megabytes) { _tt.resize(megabytes); }
+    // wipe the table, so a search doesn't depend on the ones before it
+    void        clearTranspositionTable() { _tt.clear(); }
+
+    // statistics from the last search
+    uint64_t    getNodesSearched() const { return _nodesSearched; }
+    int         getCompletedDepth() const { return _completedDepth; }
+    int         getBestScore() const { return _bestScore; }
+
+private:
+    static constexpr int ORDER_TT = 1 << 28;
+    static constexpr int ORDER_KILLER = 1 << 26;
+    static constexpr int ORDER_HINT = 1 << 21;  // hints are weighed above history but below killers
+    static constexpr int HISTORY_MAX = 1 << 20;
+
+    int         searchRoot(std::vector<int> &rootOrder, int depth, int &bestScore);
+    int         negamax(int ply, int depth, int alpha, int beta);
+    int         orderMoves(int ply, int ttMove);
+    void        updateOrdering(int ply, const Move &move, int depth);
+    bool        shouldStop();
+    bool        isLeaf(int depth) const;
+    bool        lookup(int &score) const;
+
+    // game results are stored relative to the node, everything else as it is
+    static int  toTable(int score, int ply)
+    {
+        return score > RESULT_BOUND ? score + ply : score < -RESULT_BOUND ? score - ply : score;
+    }
+    static int  fromTable(int score, int ply)
+    {
+        return score > RESULT_BOUND ? score - ply : score < -RESULT_BOUND ? score + ply : score;
+    }
+    static int  gameScore(int margin, int ply)
+    {
+        margin = std::clamp(margin, -MAX_MARGIN, MAX_MARGIN);
+        return margin > 0 ? WINNING_SCORE + margin - ply : margin < 0 ? -WINNING_SCORE + margin + ply : 0;
+    }
+
+    TranspositionTable _tt;
+    int         _timeBudgetMs;
+    int         _maxDepth;
+
+    // state of the running search
+    Position    _position;          // played forward and back as the search goes
+    std::vector<Move> _moves[MAX_PLY];      // move list of each ply, reused
+    std::vector<int> _ordered[MAX_PLY];     // the same as indices, best first
+    std::vector<int> _scores[MAX_PLY];
+    bool        _canAbort;          // only abort once one pass has finished
+    bool        _stop;
+    const std::atomic<bool> *_cancel;
+    std::chrono::steady_clock::time_point _deadline;
+    int         _killers[MAX_PLY][2];       // moveId of the last two moves that cut off at each ply
+    std::vector<int> _history[2];           // cutoff counts by side to move and moveId
+
+    uint64_t    _nodesSearched;
+    int         _completedDepth;
+    int         _bestScore;
+};
+
+template <SearchPosition Position>
+bool Search<Position>::findBestMove(const Position &position, Move &bestMove, const std::atomic<bool> *cancel)
+{
+    _position = position;
+    _tt.newSearch();
+    _stop = false;
+    _cancel = cancel;
+    _canAbort = false;
+    _deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(_timeBudgetMs);
+    _nodesSearched = 0;
+    _completedDepth = 0;
+    _bestScore = 0;
+    std::fill(&_killers[0][0], &_killers[0][0] + MAX_PLY * 2, -1);
+    for (std::vector<int> &history : _history) {
+        std::fill(history.begin(), history.end(), 0);
+    }
+
+    int margin;
+    if (_position.terminal(margin)) {
+        return false;
+    }
+    _moves[0].clear();
+    _position.generate(_moves[0]);
+    if constexpr (requires (Position &position, std::vector<Move> &moves) { position.prepareRoot(moves); }) {
+        _position.prepareRoot(_moves[0]);
+    }
+    if (_moves[0].empty()) {
+        return false;
+    }
+
+    int rootCount = orderMoves(0, -1);
+    std::vector<int> rootOrder(_ordered[0].begin(), _ordered[0].begin() + rootCount);
+    int best = rootOrder[0];
+    if (rootOrder.size() == 1) {
+        bestMove = _moves[0][best];
+        return true;    // nothing to think about
+    }
+
+    //
+    // iterative deepening: search one ply deeper each pass until the time budget runs out
+    // the best move of each pass is tried first on the next one, and an unfinished pass is thrown away
+    //
+    for (int depth = 1; depth <= _maxDepth; depth++) {
+        int score = 0;
+        int index = searchRoot(rootOrder, depth, score);
+        if (_stop || index < 0) {
+            break;
+        }
+
+        best = index;
+        _bestScore = score;
+        _completedDepth = depth;
+        _canAbort = true;   // we have a move to fall back on now
+
+        auto found = std::find(rootOrder.begin(), rootOrder.end(), index);
+        std::rotate(rootOrder.begin(), found, found + 1);
+
+        // a finished game can't get any better by looking deeper
+        if (std::abs(score) > RESULT_BOUND || std::chrono::steady_clock::now() >= _deadline) {
+            break;
+        }
+    }
+    bestMove = _moves[0][best];
+    return true;
+}
+
+// search every root move to {depth}, returns the index of the best one in _moves[0]
+template <SearchPosition Position>
+int Search<Position>::searchRoot(std::vector<int> &rootOrder, int depth, int &bestScore)
+{
+    int alpha = -WINNING_SCORE * 2;
+    int beta = WINNING_SCORE * 2;
+    int best = -1;
+
+    for (size_t i = 0; i < rootOrder.size(); i++) {
+        Move &move = _moves[0][rootOrder[i]];
+        _position.play(move);
+        // the first move gets the full window, the rest only have to show they're no better
+        int score;
+        if (i == 0) {
+            score = -negamax(1, depth - 1, -beta, -alpha);
+        } else {
+            score = -negamax(1, depth - 1, -alpha - 1, -alpha);
+            if (score > alpha && !_stop) {
+                score = -negamax(1, depth - 1, -beta, -alpha);
+            }
+        }
+        _position.undo(move);
+
+        if (_stop) {
+            return -1;
+        }
+        if (score > alpha) {
+            alpha = score;
+            best = rootOrder[i];
+        }
+    }
+
+    bestScore = alpha;
+    return best;
+}
+
+// only the clock and the cancel flag stop a search, and only after one pass has finished
+template <SearchPosition Position>
+bool Search<Position>::shouldStop()
+{
+    if (_stop) {
+        return true;
+    }
+    // poll the clock every few thousand nodes, not on every one
+    if ((++_nodesSearched & 4095) == 0) {
+        if ((_cancel && _cancel->load()) ||
+            (_canAbort && std::chrono::steady_clock::now() >= _deadline)) {
+            _stop = true;
+        }
+    }
+    return _stop;
+}
+
+// out of depth, and the position is quiet enough to evaluate
+template <SearchPosition Position>
+bool Search<Position>::isLeaf(int depth) const
+{
+    if (depth > 0) {
+        return false;
+    }
+    if constexpr (requires (const Position &position) { position.forcing(); }) {
+        return !_position.forcing();
+    }
+    return true;
+}
+
+// the position's own value for itself if it knows one, kept between the evaluations and the game results
+template <SearchPosition Position>
+bool Search<Position>::lookup(int &score) const
+{
+    if constexpr (requires (const Position &position, int &value) { position.lookup(value); }) {
+        if (_position.lookup(score)) {
+            score = std::clamp(score, -RESULT_BOUND, RESULT_BOUND);
+            return true;
+        }
+    }
+    return false;
+}
+
+// scores are from the point of view of the side to move in _position
+template <SearchPosition Position>
+int Search<Position>::negamax(int ply, int depth, int alpha, int beta)
+{
+    if (shouldStop()) return 0;    // out of time, this result is meaningless
+
+    int margin;
+    if (_position.terminal(margin)) {
+        return gameScore(margin, ply);
+    }
+    int known;
+    if (lookup(known)) {
+        return known;
+    }
+    if (isLeaf(depth) || ply >= MAX_PLY - 1) {
+        return std::clamp(_position.evaluate(), 1 - EVAL_LIMIT, EVAL_LIMIT - 1);
+    }
+    depth = std::max(depth, 0);
+
+    // transposition table lookup
+    int alphaOrig = alpha;
+    int ttMove = -1;
+    uint64_t key = _position.key();
+    TranspositionTable::Entry entry;
+    if (_tt.probe(key, entry)) {
+        ttMove = entry.move;
+        if (entry.depth >= depth) {
+            int score = fromTable(entry.score, ply);
+            if (entry.bound == TranspositionTable::BOUND_EXACT) return score;
+            if (entry.bound == TranspositionTable::BOUND_LOWER) alpha = std::max(alpha, score);
+            if (entry.bound == TranspositionTable::BOUND_UPPER) beta = std::min(beta, score);
+            if (alpha >= beta) return score;
+        }
+    }
+
+    std::vector<Move> &moves = _moves[ply];
+    moves.clear();
+    _position.generate(moves);
+    int count = orderMoves(ply, ttMove);
+
+    int bestValue = -WINNING_SCORE * 2;
+    int bestMove = -1;
+    for (int i = 0; i < count; i++) {
+        Move &move = moves[_ordered[ply][i]];
+        _position.play(move);
+        // principal variation search: after the first move, a null window only proves the
+        // move is no better, and it takes a full search when that proof fails
+        int newValue;
+        if (i == 0) {
+            newValue = -negamax(ply + 1, depth - 1, -beta, -alpha);
+        } else {
+            newValue = -negamax(ply + 1, depth - 1, -alpha - 1, -alpha);
+            if (newValue > alpha && newValue < beta && !_stop) {
+                newValue = -negamax(ply + 1, depth - 1, -beta, -alpha);
+            }
+        }
+        _position.undo(move);
+
+        if (_stop) return 0;
+
+        if (newValue > bestValue) {
+            bestValue = newValue;
+            bestMove = _ordered[ply][i];
+        }
+        alpha = std::max(alpha, newValue);
+
+        if (alpha >= beta) {    // prune
+            if (bestMove != ttMove) {
+                updateOrdering(ply, move, depth);
+            }
+            break;
+        }
+    }
+
+    TranspositionTable::Bound bound = TranspositionTable::BOUND_EXACT;
+    if (bestValue <= alphaOrig) bound = TranspositionTable::BOUND_UPPER;
+    else if (bestValue >= beta) bound = TranspositionTable::BOUND_LOWER;
+    _tt.store(key, toTable(bestValue, ply), bestMove, depth, bound);
+
+    return bestValue;
+}
+
+//
+// order the moves generated for this ply into _ordered[ply], best first
+//
+// the table's move comes first, then this ply's killers, then the rest by the position's
+// hint if it gives one and by history. returns how many moves there are
+//
+template <SearchPosition Position>
+int Search<Position>::orderMoves(int ply, int ttMove)
+{
+    const std::vector<Move> &moves = _moves[ply];
+    const std::vector<int> &history = _history[_position.playerToMove()];
+    std::vector<int> &ordered = _ordered[ply];
+    std::vector<int> &scores = _scores[ply];
+    int count = std::min((int)moves.size(), MAX_MOVES);
+    ordered.resize(count);
+    scores.resize(count);
+
+    for (int index = 0; index < count; index++) {
+        const Move &move = moves[index];
+        int id = _position.moveId(move);
+        int score;
+        if (index == ttMove) {
+            score = ORDER_TT;
+        } else if (id == _killers[ply][0]) {
+            score = ORDER_KILLER + 1;
+        } else if (id == _killers[ply][1]) {
+            score = ORDER_KILLER;
+        } else {
+            score = history[id];
+            if constexpr (requires (const Position &position) { position.orderHint(move); }) {
+                score += ORDER_HINT * _position.orderHint(move);
+            }
+        }
+
+        // insertion sort, move lists are short
+        int i = index;
+        while (i > 0 && scores[i - 1] < score) {
+            scores[i] = scores[i - 1];
+            ordered[i] = ordered[i - 1];
+            i--;
+        }
+        scores[i] = score;
+        ordered[i] = index;
+    }
+    return count;
+}
+
+// a move that caused a cutoff becomes a killer for this ply and earns history
+template <SearchPosition Position>
+void Search<Position>::updateOrdering(int ply, const Move &move, int depth)
+{
+    int id = _position.moveId(move);
+    if (_killers[ply][0] != id) {
+        _killers[ply][1] = _killers[ply][0];
+        _killers[ply][0] = id;
+    }
+
+    std::vector<int> &history = _history[_position.playerToMove()];
+    history[id] += (depth + 1) * (depth + 1);
+    if (history[id] > HISTORY_MAX) {
+        for (int &count : history) {
+            count /= 2;
+        }
+    }
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include "TicTacToePosition.h"
+#include "TicTacToeTable.h"
+#include "Connect4Position.h"
+#include "Connect4Search.h"
+#include "OthelloPosition.h"
+#include "OthelloSearch.h"
+#include "CheckersPosition.h"
+#include "CheckersSearch.h"
+
+//
+// every game's position, dressed up for Search<Position> (see Search.h)
+//
+// each one wraps the game's own position class and borrows the evaluation of its dedicated
+// engine, so the generic search plays the same game the engines do and the two can be
+// compared move for move. header only, these are all one-liners that have to inline
+//
+
+// no evaluation, the board is too small to need one
+class TicTacToeSearchPosition
+{
+public:
+    typedef int Move;
+    static const int MOVE_IDS = TicTacToePosition::SQUARES;
+
+    TicTacToeSearchPosition() {}
+    explicit TicTacToeSearchPosition(const TicTacToePosition &position) : _position(position) {}
+
+    void        generate(std::vector<Move> &moves) const
+    {
+        for (uint16_t empty = _position.emptySquares(); empty; empty &= empty - 1) {
+            moves.push_back(std::countr_zero((unsigned)empty));
+        }
+    }
+    void        play(Move square) { _position.play(square); }
+    void        undo(Move) { _position.undo(); }
+    uint64_t    key() const { return (uint64_t)TicTacToeTable::index(_position) + 1; }
+    int         evaluate() const { return 0; }
+    bool        terminal(int &margin) const
+    {
+        margin = 0;
+        if (TicTacToePosition::hasLine(_position.board(_position.playerToMove() ^ 1))) {
+            margin = -1;
+            return true;
+        }
+        return _position.isFull();
+    }
+    int         moveId(Move square) const { return square; }
+    int         playerToMove() const { return _position.playerToMove(); }
+
+    const TicTacToePosition &position() const { return _position; }
+
+private:
+    TicTacToePosition _position;
+};
+
+// the threat evaluation, and columns nearer the middle first
+class Connect4SearchPosition
+{
+public:
+    typedef int Move;
+    static const int MOVE_IDS = Connect4Position::WIDTH;
+
+    Connect4SearchPosition() {}
+    explicit Connect4SearchPosition(const Connect4Position &position) : _position(position) {}
+
+    void        generate(std::vector<Move> &moves) const
+    {
+        for (int column = 0; column < Connect4Position::WIDTH; column++) {
+            if (_position.canPlay(column)) {
+                moves.push_back(column);
+            }
+        }
+    }
+    void        play(Move column) { _position.play(column); }
+    void        undo(Move) { _position.undo(); }
+    uint64_t    key() const { return _position.key(); }
+    int         evaluate() const { return Connect4Search::evalThreats(_position.current(), _position.opponent()); }
+    bool        terminal(int &margin) const
+    {
+        margin = 0;
+        if (Connect4Search::isWin(_position.opponent())) {
+            margin = -1;
+            return true;
+        }
+        return _position.isFull();
+    }
+    int         moveId(Move column) const { return column; }
+    int         orderHint(Move column) const { return 3 - std::abs(column - 3); }
+    int         playerToMove() const { return _position.playerToMove(); }
+
+    const Connect4Position &position() const { return _position; }
+
+private:
+    Connect4Position _position;
+};
+
+// the hand-tuned evaluation. a side with no move passes, and the disc count breaks ties
+// between won games
+class OthelloSearchPosition
+{
+public:
+    struct Move
+    {
+        int         square;     // -1 to pass
+        uint64_t    flipped;    // filled in by play()
+    };
+    static const int MOVE_IDS = OthelloPosition::SQUARES + 1;
+
+    OthelloSearchPosition() {}
+    explicit OthelloSearchPosition(const OthelloPosition &position) : _position(position) {}
+
+    void        generate(std::vector<Move> &moves) const
+    {
+        uint64_t legal = _position.legalMoves();
+        if (!legal) {
+            moves.push_back({-1, 0});
+        }
+        for (; legal; legal &= legal - 1) {
+            moves.push_back({std::countr_zero(legal), 0});
+        }
+    }
+    void        play(Move &move)
+    {
+        if (move.square < 0) {
+            _position.pass();
+        } else {
+            move.flipped = _position.play(move.square);
+        }
+    }
+    void        undo(const Move &move)
+    {
+        if (move.square < 0) {
+            _position.pass();
+        } else {
+            _position.undo(move.square, move.flipped);
+        }
+    }
+    uint64_t    key() const { return OthelloSearch::positionKey(_position.current(), _position.opponent()); }
+    int         evaluate() const { return OthelloSearch::evaluate(_position.current(), _position.opponent()); }
+    bool        terminal(int &margin) const
+    {
+        margin = 0;
+        if (!_position.isGameOver()) {
+            return false;
+        }
+        // empty squares go to the winner, like OthelloSearch::finalScore
+        int difference = std::popcount(_position.current()) - std::popcount(_position.opponent());
+        int empties = _position.emptyCount();
+        margin = difference > 0 ? difference + empties : difference < 0 ? difference - empties : 0;
+        return true;
+    }
+    int         moveId(const Move &move) const { return move.square + 1; }
+    int         playerToMove() const { return _position.playerToMove(); }
+
+    const OthelloPosition &position() const { return _position; }
+
+private:
+    OthelloPosition _position;
+};
+
+// CheckersSearchPosition is in CheckersSearch.h, the checkers engine is built on it
@@ -30,6 +30,7 @@ void TicTacToe::setUpBoard()
     _gameOptions.rowX = 3;
     _gameOptions.rowY = 3;
     _grid->initializeSquares(80, "square.png");
+    _position.reset();
 
     if (gameHasAI()) {
         setAIPlayer(AI_PLAYER);
@@ -46,10 +47,16 @@ bool TicTacToe::actionForEmptyHolder(BitHolder &holder)
     if (holder.bit()) {
         return false;
     }
+    ChessSquare *square = static_cast<ChessSquare *>(&holder);
+    int index = square->getRow() * 3 + square->getColumn();
+    if (!_position.canPlay(index)) {
+        return false;
+    }
     Bit *bit = PieceForPlayer(getCurrentPlayer()->playerNumber() == 0 ? HUMAN_PLAYER : AI_PLAYER);
     if (bit) {
         bit->setPosition(holder.getPosition());
         holder.setBit(bit);
+        _position.play(index);
         endTurn();
         return true;
     }   
@@ -78,42 +85,15 @@ void TicTacToe::stopGame()
     });
 }
 
-//
-// helper function for the winner check
-//
-Player* TicTacToe::ownerAt(int index ) const
-{
-    auto square = _grid->getSquare(index % 3, index / 3);
-    if (!square || !square->bit()) {
-        return nullptr;
-    }
-    return square->bit()->getOwner();
-}
-
 Player* TicTacToe::checkForWinner()
 {
-    static const int kWinningTriples[8][3] =  { {0,1,2}, {3,4,5}, {6,7,8},  // rows
-                                                {0,3,6}, {1,4,7}, {2,5,8},  // cols
-                                                {0,4,8}, {2,4,6} };         // diagonals
-    for( int i=0; i<8; i++ ) {
-        const int *triple = kWinningTriples[i];
-        Player *player = ownerAt(triple[0]);
-        if( player && player == ownerAt(triple[1]) && player == ownerAt(triple[2]) )
-            return player;
-    }
-    return nullptr;
+    int winner = _position.winner();
+    return (winner < 0) ? nullptr : getPlayerAt(winner);
 }
 
 bool TicTacToe::checkForDraw()
 {
-    bool isDraw = true;
-    // check to see if the board is full
-    _grid->forEachSquare([&isDraw](ChessSquare* square, int x, int y) {
-        if (!square->bit()) {
-            isDraw = false;
-        }
-    });
-    return isDraw;
+    return _position.isDraw();
 }
 
 //
@@ -146,11 +126,13 @@ std::string TicTacToe::stateString()
 //
 void TicTacToe::setStateString(const std::string &s)
 {
+    _position.reset();
     _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
         int index = y*3 + x;
         int playerNumber = s[index] - '0';
         if (playerNumber) {
             square->setBit( PieceForPlayer(playerNumber-1) );
+            _position.setPiece(index, playerNumber - 1);
         } else {
             square->setBit( nullptr );
         }
@@ -160,25 +142,12 @@ void TicTacToe::setStateString(const std::string &s)
 
 //
 // this is the function that will be called by the AI
+// the whole game is solved in TicTacToeTable, so perfect play is one lookup
 //
 void TicTacToe::updateAI() 
 {
-    BitHolder* bestMove = nullptr;
-    std::string state = stateString();
-
-    // Traverse all cells, evaluate minimax function for all empty cells
-    _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
-        int index = y * 3 + x;
-        // Check if cell is empty
-        if (state[index] == '0') {
-            bestMove = square;
-        }
-    });
-
-
-    // Make the best move
-    if(bestMove) {
-        if (actionForEmptyHolder(*bestMove)) {
-        }
+    int move = TicTacToeTable::bestMove(_position);
+    if (move >= 0) {
+        actionForEmptyHolder(*_grid->getSquare(move % 3, move / 3));
     }
 }
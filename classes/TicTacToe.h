@@ -1,5 +1,7 @@
 #pragma once
 #include "Game.h"
+#include "TicTacToePosition.h"
+#include "TicTacToeTable.h"
 
 //
 // the classic game of tic tac toe
@@ -32,9 +34,8 @@ public:
     Grid* getGrid() override { return _grid; }
 private:
     Bit *       PieceForPlayer(const int playerNumber);
-    Player*     ownerAt(int index ) const;
-    int         negamax(std::string& state, int depth, int playerColor);
 
     Grid*       _grid;
+    TicTacToePosition _position;    // rules live here, the grid just shows it
 };
 
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+
+//
+// tic tac toe position, one 9-bit board per player
+//
+// squares are numbered y * 3 + x like the grid. player 0 (X) always moves first,
+// so the side to move is the parity of the move count.
+// header only, there's nothing here worth a translation unit
+//
+class TicTacToePosition
+{
+public:
+    static const int SQUARES = 9;
+
+    TicTacToePosition() { reset(); }
+
+    void        reset()
+    {
+        _boards[0] = 0;
+        _boards[1] = 0;
+        _moveCount = 0;
+        _firstMove = 0;
+    }
+
+    bool        canPlay(int square) const { return !((filled() >> square) & 1); }
+
+    // the square must be empty
+    void        play(int square)
+    {
+        _boards[_moveCount & 1] |= (uint16_t)(1 << square);
+        _moves[_moveCount++] = (uint8_t)square;
+    }
+
+    // take back the last move, returns its square
+    int         undo()
+    {
+        int square = _moves[--_moveCount];
+        _boards[_moveCount & 1] &= (uint16_t)~(1 << square);
+        return square;
+    }
+
+    bool        canUndo() const { return _moveCount > _firstMove; }
+
+    // place a piece outside of the move order, for setting up a position from a state string
+    // there's no history for these, so undo() can't take them back
+    void        setPiece(int square, int player)
+    {
+        _boards[player] |= (uint16_t)(1 << square);
+        _moveCount = std::popcount((unsigned)filled());
+        _firstMove = _moveCount;
+    }
+
+    uint16_t    board(int player) const { return _boards[player]; }
+    uint16_t    filled() const { return _boards[0] | _boards[1]; }
+    uint16_t    emptySquares() const { return (uint16_t)(~filled() & ALL_SQUARES); }
+    int         moveCount() const { return _moveCount; }
+    int         playerToMove() const { return _moveCount & 1; }
+
+    bool        isWin(int player) const { return hasLine(_boards[player]); }
+
+    // three in a row anywhere on a 9-bit board
+    static constexpr bool hasLine(uint16_t board)
+    {
+        for (uint16_t line : LINES) {
+            if ((board & line) == line) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // the player with three in a row, -1 if nobody has one yet
+    int         winner() const
+    {
+        if (isWin(0)) return 0;
+        if (isWin(1)) return 1;
+        return -1;
+    }
+
+    bool        isFull() const { return filled() == ALL_SQUARES; }
+    bool        isDraw() const { return isFull() && winner() < 0; }
+
+private:
+    static const uint16_t ALL_SQUARES = 0x1ff;
+    static constexpr uint16_t LINES[8] = {
+        0x007, 0x038, 0x1c0,    // rows
+        0x049, 0x092, 0x124,    // columns
+        0x111, 0x054            // diagonals
+    };
+
+    uint16_t    _boards[2];
+    uint8_t     _moves[SQUARES];
+    int         _moveCount;
+    int         _firstMove;     // undo stops here
+};
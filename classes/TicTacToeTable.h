@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "TicTacToePosition.h"
+
+//
+// perfect play for every tic tac toe position, worked out by the compiler
+//
+// a position's index is its state string read as a base 3 number, square 0 the lowest digit:
+// 0 empty, 1 player 0 (X), 2 player 1 (O). that's 3^9 entries, of which 5,478 are positions
+// a game can reach; the rest hold no move. each entry has the score for the side to move and
+// the move that gets it. a win scores 10 less the number of pieces on the board when it
+// happens, so the table plays the quickest win and the longest loss, and a draw scores 0.
+// adding a piece only ever raises the index, so one pass from the top down solves it all.
+// header only, the table is built at compile time
+//
+class TicTacToeTable
+{
+public:
+    struct Entry
+    {
+        int8_t  score;      // for the side to move
+        int8_t  move;       // square to play, -1 if the game is over or no game reaches this
+    };
+
+    static const int SIZE = 19683;  // 3^9
+    static const int WINNING_SCORE = 10;
+
+    static constexpr int index(uint16_t board0, uint16_t board1)
+    {
+        return SPREAD[board0] + 2 * SPREAD[board1];
+    }
+    static int          index(const TicTacToePosition &position) { return index(position.board(0), position.board(1)); }
+
+    static const Entry &lookup(const TicTacToePosition &position) { return TABLE[index(position)]; }
+    static int          bestMove(const TicTacToePosition &position) { return lookup(position).move; }
+    static int          score(const TicTacToePosition &position) { return lookup(position).score; }
+
+private:
+    static constexpr int POWERS[TicTacToePosition::SQUARES] = { 1, 3, 9, 27, 81, 243, 729, 2187, 6561 };
+
+    // a 9-bit board with each bit moved to its base 3 digit
+    static constexpr std::array<int, 512> spread()
+    {
+        std::array<int, 512> table{};
+        for (int board = 0; board < 512; board++) {
+            for (int square = 0; square < TicTacToePosition::SQUARES; square++) {
+                if ((board >> square) & 1) {
+                    table[board] += POWERS[square];
+                }
+            }
+        }
+        return table;
+    }
+
+    static constexpr std::array<Entry, SIZE> build()
+    {
+        std::array<Entry, SIZE> table{};
+        for (int position = SIZE - 1; position >= 0; position--) {
+            uint16_t boards[2] = { 0, 0 };
+            for (int square = 0, digits = position; square < TicTacToePosition::SQUARES; square++, digits /= 3) {
+                if (digits % 3) {
+                    boards[digits % 3 - 1] |= (uint16_t)(1 << square);
+                }
+            }
+            int counts[2] = { std::popcount((unsigned)boards[0]), std::popcount((unsigned)boards[1]) };
+            Entry &entry = table[position];
+            entry = { 0, -1 };
+            if (counts[0] != counts[1] && counts[0] != counts[1] + 1) {
+                continue;
+            }
+            int player = counts[0] - counts[1];
+            int pieces = counts[0] + counts[1];
+            if (TicTacToePosition::hasLine(boards[player ^ 1])) {
+                entry.score = (int8_t)-(WINNING_SCORE - pieces);
+                continue;
+            }
+            // every child has one more piece, so a higher index, and is already solved
+            int best = -WINNING_SCORE - 1;
+            for (int square = 0; square < TicTacToePosition::SQUARES; square++) {
+                if (((boards[0] | boards[1]) >> square) & 1) {
+                    continue;
+                }
+                int score = -table[position + (player + 1) * POWERS[square]].score;
+                if (score > best) {
+                    best = score;
+                    entry = { (int8_t)score, (int8_t)square };
+                }
+            }
+        }
+        return table;
+    }
+
+    static const std::array<int, 512> SPREAD;
+    static const std::array<Entry, SIZE> TABLE;
+};
+
+inline constexpr std::array<int, 512> TicTacToeTable::SPREAD = TicTacToeTable::spread();
+inline constexpr std::array<TicTacToeTable::Entry, TicTacToeTable::SIZE> TicTacToeTable::TABLE = TicTacToeTable::build();
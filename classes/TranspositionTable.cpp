@@ -0,0 +1,116 @@
+#include "TranspositionTable.h"
+
+TranspositionTable::TranspositionTable(size_t megabytes)
+{
+    _bucketCount = 0;
+    _mask = 0;
+    _age = 0;
+    resize(megabytes);
+}
+
+void TranspositionTable::resize(size_t megabytes)
+{
+    size_t bytes = (megabytes ? megabytes : 1) * 1024 * 1024;
+    size_t count = 1;
+    while (count * 2 * sizeof(Bucket) <= bytes) {
+        count *= 2;
+    }
+
+    // atomics can't be copied, so build a fresh vector rather than assigning
+    std::vector<Bucket> buckets(count);
+    _buckets.swap(buckets);
+    _bucketCount = count;
+    _mask = count - 1;
+    clear();
+}
+
+void TranspositionTable::clear()
+{
+    for (Bucket &bucket : _buckets) {
+        for (Slot &slot : bucket.slots) {
+            slot.keyXorData.store(0, std::memory_order_relaxed);
+            slot.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    _age = 0;
+}
+
+// keys built from bitboards are far from uniform, so mix them before masking
+size_t TranspositionTable::bucketIndex(uint64_t key) const
+{
+    return (size_t)(((key * 0x9E3779B97F4A7C15ull) >> 32) & _mask);
+}
+
+// data layout: score (16) | move (8) | depth (8) | bound (8) | age (8)
+uint64_t TranspositionTable::pack(int score, int move, int depth, Bound bound, uint8_t age)
+{
+    return (uint64_t)(uint16_t)(int16_t)score
+         | (uint64_t)(uint8_t)(int8_t)move << 16
+         | (uint64_t)(uint8_t)(depth < 0 ? 0 : depth) << 24
+         | (uint64_t)bound << 32
+         | (uint64_t)age << 40;
+}
+
+TranspositionTable::Entry TranspositionTable::unpack(uint64_t key, uint64_t data)
+{
+    Entry entry;
+    entry.key = key;
+    entry.score = (int16_t)(data & 0xffff);
+    entry.move = (int8_t)((data >> 16) & 0xff);
+    entry.depth = (uint8_t)((data >> 24) & 0xff);
+    entry.bound = (uint8_t)((data >> 32) & 0xff);
+    entry.age = (uint8_t)((data >> 40) & 0xff);
+    return entry;
+}
+
+bool TranspositionTable::probe(uint64_t key, Entry &entry) const
+{
+    const Bucket &bucket = _buckets[bucketIndex(key)];
+    for (const Slot &slot : bucket.slots) {
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        uint64_t keyXorData = slot.keyXorData.load(std::memory_order_relaxed);
+        if ((keyXorData ^ data) == key && ((data >> 32) & 0xff) != BOUND_NONE) {
+            entry = unpack(key, data);
+            return true;
+        }
+    }
+    return false;
+}
+
+//
+// replacement policy: overwrite the same position if it is already here, otherwise
+// evict the entry from the oldest search, breaking ties by the shallowest depth
+//
+void TranspositionTable::store(uint64_t key, int score, int move, int depth, Bound bound)
+{
+    Bucket &bucket = _buckets[bucketIndex(key)];
+    Slot *victim = &bucket.slots[0];
+    Entry victimEntry = Entry{0, 0, -1, 0, BOUND_NONE, 0};
+    int victimWorth = 1 << 30;
+
+    for (Slot &slot : bucket.slots) {
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        uint64_t slotKey = slot.keyXorData.load(std::memory_order_relaxed) ^ data;
+        Entry e = unpack(slotKey, data);
+        if (e.bound == BOUND_NONE || e.key == key) {
+            victim = &slot;
+            victimEntry = e;
+            break;
+        }
+        int worth = e.depth - 256 * (uint8_t)(_age - e.age);
+        if (worth < victimWorth) {
+            victimWorth = worth;
+            victim = &slot;
+            victimEntry = e;
+        }
+    }
+
+    // keep the old best move if this search didn't produce one
+    if (move < 0 && victimEntry.key == key && victimEntry.bound != BOUND_NONE) {
+        move = victimEntry.move;
+    }
+
+    uint64_t data = pack(score, move, depth, bound, _age);
+    victim->keyXorData.store(key ^ data, std::memory_order_relaxed);
+    victim->data.store(data, std::memory_order_relaxed);
+}
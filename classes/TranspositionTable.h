@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <atomic>
+
+//
+// fixed-size transposition table for the game searches
+// entries are grouped into buckets the size of one cache line, so a probe
+// only ever touches a single line of memory
+//
+// the table is shared by every search thread without locks: each entry stores
+// its key xor'd with its data, so a torn write from two threads racing on the
+// same slot just reads back as a miss
+//
+class TranspositionTable
+{
+public:
+    enum Bound : uint8_t
+    {
+        BOUND_NONE = 0,
+        BOUND_EXACT,
+        BOUND_LOWER,    // score is at least this (fail high)
+        BOUND_UPPER     // score is at most this (fail low)
+    };
+
+    // unpacked copy of a table entry
+    struct Entry
+    {
+        uint64_t key;
+        int16_t  score;
+        int8_t   move;
+        uint8_t  depth;
+        uint8_t  bound;
+        uint8_t  age;
+    };
+
+    static const int ENTRIES_PER_BUCKET = 4;
+    static const size_t DEFAULT_MEGABYTES = 16;
+
+    struct Slot
+    {
+        std::atomic<uint64_t> keyXorData;
+        std::atomic<uint64_t> data;
+    };
+
+    struct alignas(64) Bucket
+    {
+        Slot slots[ENTRIES_PER_BUCKET];
+    };
+
+    TranspositionTable(size_t megabytes = DEFAULT_MEGABYTES);
+
+    // reallocate the table to fit in the given memory budget (rounded down to a power of two buckets)
+    // not safe while a search is running
+    void        resize(size_t megabytes);
+    // wipe every entry, not safe while a search is running
+    void        clear();
+    // mark the start of a new search so older entries get replaced first
+    void        newSearch() { _age++; }
+
+    bool        probe(uint64_t key, Entry &entry) const;
+    void        store(uint64_t key, int score, int move, int depth, Bound bound);
+
+    size_t      sizeInBytes() const { return _bucketCount * sizeof(Bucket); }
+    size_t      entryCount() const { return _bucketCount * ENTRIES_PER_BUCKET; }
+
+private:
+    size_t      bucketIndex(uint64_t key) const;
+    static uint64_t pack(int score, int move, int depth, Bound bound, uint8_t age);
+    static Entry    unpack(uint64_t key, uint64_t data);
+
+    std::vector<Bucket> _buckets;
+    size_t      _bucketCount;
+    uint64_t    _mask;
+    uint8_t     _age;
+};
@@ -0,0 +1,463 @@
+//
+// deterministic benchmark for every AI engine in the gameengine library
+//
+// reads one position per line from a test-data file (tools/bench_positions.txt):
+//   <game> <engine> <depth> <position> [name]
+// with positions written as
+//   connect4    the columns played from the empty board, "-" for the empty board
+//   othello     the 64 character state string followed by b or w for the side to move
+//   checkers    the 32 character state string followed by r or y for the side to move
+//   tictactoe   the 9 character state string, "-" for the empty board
+// the generic engine is Search<Position> from Search.h, on any of the four games, and mcts is
+// MonteCarloSearch<Position> from MonteCarloSearch.h, whose depth is thousands of playouts. its
+// nodes are playouts and its score is the chosen move's win rate in percent
+//
+// every search runs single threaded to a fixed depth with a fresh table, so the node
+// counts and moves only change when the engines do. --time gives every search a time
+// budget instead, which is closer to play but no longer reproducible. the othello search uses
+// its hand-tuned evaluation unless --weights gives it a pattern weights file, and the checkers
+// search only uses an endgame database when --endgame gives it one
+//
+// usage: bench_ai [positions file] [--json] [--time ms] [--weights file] [--endgame file]
+//
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../classes/Connect4Search.h"
+#include "../classes/Connect4Solver.h"
+#include "../classes/OthelloRules.h"
+#include "../classes/OthelloSearch.h"
+#include "../classes/OthelloSolver.h"
+#include "../classes/OthelloPatterns.h"
+#include "../classes/CheckersSearch.h"
+#include "../classes/Search.h"
+#include "../classes/MonteCarloSearch.h"
+#include "../classes/SearchPositions.h"
+
+#ifndef BENCH_POSITIONS_FILE
+#define BENCH_POSITIONS_FILE "tools/bench_positions.txt"
+#endif
+
+struct BenchCase
+{
+    std::string game;
+    std::string engine;
+    int         depth;
+    std::string position;
+    std::string side;       // othello and checkers only
+    std::string name;
+};
+
+struct BenchResult
+{
+    uint64_t    nodes;
+    double      seconds;
+    int         depth;          // depth actually completed
+    double      branching;      // nodes at depth / nodes at depth - 1, 0 if there's nothing to compare
+    int         move;
+    int         score;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+// --weights, shared by every othello search
+static OthelloPatterns othelloPatterns;
+// --endgame, shared by every checkers search
+static CheckersEndgame checkersEndgame;
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static bool parseConnect4(const std::string &moves, Connect4Position &position)
+{
+    if (moves == "-") return true;
+    for (char c : moves) {
+        int col = c - '0';
+        if (col < 0 || col > 6 || !position.canPlay(col)) return false;
+        position.play(col);
+    }
+    return true;
+}
+
+static bool parseOthello(const BenchCase &bench, OthelloPosition &position)
+{
+    if (bench.side != "b" && bench.side != "w") return false;
+    return position.setState(bench.position, bench.side == "b" ? OthelloPosition::BLACK : OthelloPosition::WHITE);
+}
+
+static bool parseCheckers(const BenchCase &bench, CheckersPosition &position)
+{
+    if (bench.side != "r" && bench.side != "y") return false;
+    return position.setState(bench.position, bench.side == "r" ? CheckersPosition::RED : CheckersPosition::YELLOW);
+}
+
+static bool parseTicTacToe(const std::string &text, TicTacToePosition &position)
+{
+    if (text == "-") return true;
+    if (text.length() != TicTacToePosition::SQUARES) return false;
+    for (int square = 0; square < TicTacToePosition::SQUARES; square++) {
+        if (text[square] == '1' || text[square] == '2') {
+            position.setPiece(square, text[square] - '1');
+        } else if (text[square] != '0') {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool runConnect4Search(const BenchCase &bench, int timeMs, BenchResult &result)
+{
+    Connect4Position position;
+    if (!parseConnect4(bench.position, position)) return false;
+
+    Connect4Search search;
+    search.setThreads(1);
+    search.setTimeBudget(timeMs > 0 ? timeMs : 24 * 60 * 60 * 1000);
+
+    // the pass one ply shallower gives the effective branching factor
+    uint64_t previousNodes = 0;
+    if (timeMs <= 0 && bench.depth > 1) {
+        search.setMaxDepth(bench.depth - 1);
+        search.findBestMove(position);
+        previousNodes = search.getNodesSearched();
+        search.clearTranspositionTable();
+    }
+
+    search.setMaxDepth(timeMs > 0 ? 42 : bench.depth);
+    auto start = Clock::now();
+    result.move = search.findBestMove(position);
+    result.seconds = secondsSince(start);
+    result.nodes = search.getNodesSearched();
+    result.depth = search.getCompletedDepth();
+    result.score = search.getBestScore();
+    result.branching = previousNodes ? (double)result.nodes / previousNodes : 0.0;
+    return true;
+}
+
+static bool runConnect4Solver(const BenchCase &bench, int timeMs, BenchResult &result)
+{
+    Connect4Position position;
+    if (!parseConnect4(bench.position, position)) return false;
+
+    Connect4Solver solver;
+    solver.setTimeBudget(timeMs > 0 ? timeMs : 24 * 60 * 60 * 1000);
+
+    auto start = Clock::now();
+    result.move = solver.bestMove(position.current(), position.opponent(), result.score);
+    result.seconds = secondsSince(start);
+    result.nodes = solver.getNodesSearched();
+    result.depth = Connect4Position::WIDTH * Connect4Position::HEIGHT - position.moveCount();
+    result.branching = 0.0;
+    return true;
+}
+
+static bool runOthelloGreedy(const BenchCase &bench, int timeMs, BenchResult &result)
+{
+    if (bench.position.length() != 64 || (bench.side != "b" && bench.side != "w")) return false;
+    char piece = (bench.side == "b") ? OthelloRules::BLACK : OthelloRules::WHITE;
+
+    // one ply with every square as a node, repeated so the time is measurable
+    const int repeats = 10000;
+    auto start = Clock::now();
+    for (int i = 0; i < repeats; i++) {
+        result.move = OthelloRules::findGreedyMove(bench.position, piece);
+    }
+    result.seconds = secondsSince(start);
+    result.nodes = 64ULL * repeats;
+    result.depth = 1;
+    result.score = (result.move >= 0) ? OthelloRules::countFlips(bench.position, result.move % 8, result.move / 8, piece) : 0;
+    result.branching = 0.0;
+    return true;
+}
+
+static bool runOthelloSearch(const BenchCase &bench, int timeMs, BenchResult &result)
+{
+    OthelloPosition position;
+    if (bench.side != "b" && bench.side != "w") return false;
+    if (!position.setState(bench.position, bench.side == "b" ? OthelloPosition::BLACK : OthelloPosition::WHITE)) return false;
+
+    // a fresh table for every search, the engine normally keeps it from move to move
+    OthelloSearch search;
+    search.setTimeBudget(timeMs > 0 ? timeMs : 24 * 60 * 60 * 1000);
+    search.setPatterns(&othelloPatterns);
+
+    uint64_t previousNodes = 0;
+    if (timeMs <= 0 && bench.depth > 1) {
+        search.setMaxDepth(bench.depth - 1);
+        search.findBestMove(position);
+        previousNodes = search.getNodesSearched();
+        search.clearTranspositionTable();
+    }
+
+    search.setMaxDepth(timeMs > 0 ? 60 : bench.depth);
+    auto start = Clock::now();
+    result.move = search.findBestMove(position);
+    result.seconds = secondsSince(start);
+    result.nodes = search.getNodesSearched();
+    result.depth = search.getCompletedDepth();
+    result.score = search.getBestScore();
+    result.branching = previousNodes ? (double)result.nodes / previousNodes : 0.0;
+    return true;
+}
+
+static bool runOthelloSolver(const BenchCase &bench, int timeMs, BenchResult &result)
+{
+    OthelloPosition position;
+    if (bench.side != "b" && bench.side != "w") return false;
+    if (!position.setState(bench.position, bench.side == "b" ? OthelloPosition::BLACK : OthelloPosition::WHITE)) return false;
+
+    OthelloSolver solver;
+    if (timeMs > 0) {
+        solver.setTimeBudget(timeMs);
+    }
+
+    auto start = Clock::now();
+    result.move = solver.bestMove(position, result.score);
+    result.seconds = secondsSince(start);
+    result.nodes = solver.getNodesSearched();
+    result.depth = position.emptyCount();
+    result.branching = 0.0;
+    return true;
+}
+
+// the move is an index into the position's generateMoves() list
+static bool runCheckersSearch(const BenchCase &bench, int timeMs, BenchResult &result)
+{
+    CheckersPosition position;
+    if (bench.side != "r" && bench.side != "y") return false;
+    if (!position.setState(bench.position, bench.side == "r" ? CheckersPosition::RED : CheckersPosition::YELLOW)) return false;
+
+    // a fresh table for every search, the engine normally keeps it from move to move
+    CheckersSearch search;
+    search.setTimeBudget(timeMs > 0 ? timeMs : 24 * 60 * 60 * 1000);
+    search.setEndgame(&checkersEndgame);
+
+    uint64_t previousNodes = 0;
+    if (timeMs <= 0 && bench.depth > 1) {
+        search.setMaxDepth(bench.depth - 1);
+        search.findBestMove(position);
+        previousNodes = search.getNodesSearched();
+        search.clearTranspositionTable();
+    }
+
+    search.setMaxDepth(timeMs > 0 ? CheckersSearch::MAX_DEPTH : bench.depth);
+    auto start = Clock::now();
+    result.move = search.findBestMove(position);
+    result.seconds = secondsSince(start);
+    result.nodes = search.getNodesSearched();
+    result.depth = search.getCompletedDepth();
+    result.score = search.getBestScore();
+    result.branching = previousNodes ? (double)result.nodes / previousNodes : 0.0;
+    return true;
+}
+
+//
+// Search<Position> on any game. {moveNumber} turns its move into the number the game's own
+// engine would report, so the two can be compared row for row
+//
+template <typename Position, typename MoveNumber>
+static bool runGenericSearch(const Position &position, const BenchCase &bench, int timeMs, BenchResult &result,
+                             MoveNumber moveNumber)
+{
+    // the search is too big for the stack with its per-ply move lists
+    auto search = std::make_unique<Search<Position>>();
+    search->setTimeBudget(timeMs > 0 ? timeMs : 24 * 60 * 60 * 1000);
+
+    uint64_t previousNodes = 0;
+    if (timeMs <= 0 && bench.depth > 1) {
+        search->setMaxDepth(bench.depth - 1);
+        typename Position::Move move;
+        search->findBestMove(position, move);
+        previousNodes = search->getNodesSearched();
+        search->clearTranspositionTable();
+    }
+
+    search->setMaxDepth(timeMs > 0 ? Search<Position>::MAX_PLY : bench.depth);
+    typename Position::Move move;
+    auto start = Clock::now();
+    bool found = search->findBestMove(position, move);
+    result.seconds = secondsSince(start);
+    result.move = found ? moveNumber(move) : -1;
+    result.nodes = search->getNodesSearched();
+    result.depth = search->getCompletedDepth();
+    result.score = search->getBestScore();
+    result.branching = previousNodes ? (double)result.nodes / previousNodes : 0.0;
+    return true;
+}
+
+//
+// MonteCarloSearch<Position> on any game, for a fixed number of playouts from a fixed seed
+// with a fresh tree, or for the time budget with --time
+//
+template <typename Position, typename MoveNumber>
+static bool runMonteCarlo(const Position &position, const BenchCase &bench, int timeMs, BenchResult &result,
+                          MoveNumber moveNumber)
+{
+    MonteCarloSearch<Position> search;
+    search.setTreeReuse(false);
+    search.setTimeBudget(timeMs > 0 ? timeMs : 24 * 60 * 60 * 1000);
+    search.setMaxPlayouts(timeMs > 0 ? 0 : (uint64_t)bench.depth * 1000);
+
+    typename Position::Move move;
+    auto start = Clock::now();
+    bool found = search.findBestMove(position, move);
+    result.seconds = secondsSince(start);
+    result.move = found ? moveNumber(move) : -1;
+    result.nodes = search.getPlayouts();
+    result.depth = (int)search.getPrincipalVariation().size();
+    result.score = (int)(search.getWinRate() * 100 + 0.5);
+    result.branching = 0.0;
+    return true;
+}
+
+// the generic search or, with {monteCarlo}, the monte carlo one
+static bool runGeneric(const BenchCase &bench, int timeMs, BenchResult &result, bool monteCarlo)
+{
+    auto runSearch = [&](const auto &position, auto moveNumber) {
+        if (monteCarlo) return runMonteCarlo(position, bench, timeMs, result, moveNumber);
+        return runGenericSearch(position, bench, timeMs, result, moveNumber);
+    };
+    if (bench.game == "tictactoe") {
+        TicTacToePosition position;
+        if (!parseTicTacToe(bench.position, position)) return false;
+        return runSearch(TicTacToeSearchPosition(position), [](int square) { return square; });
+    }
+    if (bench.game == "connect4") {
+        Connect4Position position;
+        if (!parseConnect4(bench.position, position)) return false;
+        return runSearch(Connect4SearchPosition(position), [](int column) { return column; });
+    }
+    if (bench.game == "othello") {
+        OthelloPosition position;
+        if (!parseOthello(bench, position)) return false;
+        return runSearch(OthelloSearchPosition(position),
+                         [](const OthelloSearchPosition::Move &move) { return move.square; });
+    }
+    if (bench.game == "checkers") {
+        CheckersPosition position;
+        if (!parseCheckers(bench, position)) return false;
+        // CheckersSearch reports the move's index in generateMoves()
+        std::vector<CheckersPosition::Move> moves;
+        position.generateMoves(moves);
+        return runSearch(CheckersSearchPosition(position),
+                         [&moves](const CheckersPosition::Move &move) {
+            for (size_t i = 0; i < moves.size(); i++) {
+                if (moves[i].from == move.from && moves[i].to == move.to && moves[i].captured == move.captured) {
+                    return (int)i;
+                }
+            }
+            return -1;
+        });
+    }
+    return false;
+}
+
+static bool runCase(const BenchCase &bench, int timeMs, BenchResult &result)
+{
+    if (bench.engine == "generic") return runGeneric(bench, timeMs, result, false);
+    if (bench.engine == "mcts") return runGeneric(bench, timeMs, result, true);
+    if (bench.game == "connect4" && bench.engine == "search") return runConnect4Search(bench, timeMs, result);
+    if (bench.game == "connect4" && bench.engine == "solver") return runConnect4Solver(bench, timeMs, result);
+    if (bench.game == "othello" && bench.engine == "greedy") return runOthelloGreedy(bench, timeMs, result);
+    if (bench.game == "othello" && bench.engine == "search") return runOthelloSearch(bench, timeMs, result);
+    if (bench.game == "othello" && bench.engine == "solver") return runOthelloSolver(bench, timeMs, result);
+    if (bench.game == "checkers" && bench.engine == "search") return runCheckersSearch(bench, timeMs, result);
+    return false;
+}
+
+static bool loadCases(const char *path, std::vector<BenchCase> &cases)
+{
+    std::ifstream file(path);
+    if (!file) return false;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        BenchCase bench;
+        fields >> bench.game >> bench.engine >> bench.depth >> bench.position;
+        if (bench.game == "othello" || bench.game == "checkers") {
+            fields >> bench.side;
+        }
+        fields >> bench.name;
+        if (bench.name.empty()) {
+            bench.name = bench.position;
+        }
+        cases.push_back(bench);
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = BENCH_POSITIONS_FILE;
+    bool json = false;
+    int timeMs = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) json = true;
+        else if (strcmp(argv[i], "--time") == 0 && i + 1 < argc) timeMs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--weights") == 0 && i + 1 < argc) {
+            if (!othelloPatterns.open(argv[++i])) {
+                fprintf(stderr, "couldn't load weights from %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--endgame") == 0 && i + 1 < argc) {
+            if (!checkersEndgame.open(argv[++i])) {
+                fprintf(stderr, "couldn't load the endgame database from %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else path = argv[i];
+    }
+
+    std::vector<BenchCase> cases;
+    if (!loadCases(path, cases)) {
+        fprintf(stderr, "couldn't read %s\n", path);
+        return 1;
+    }
+
+    if (json) {
+        printf("[\n");
+    } else {
+        printf("game,engine,name,depth,nodes,seconds,nps,branching,move,score\n");
+    }
+
+    bool first = true;
+    int failures = 0;
+    for (const BenchCase &bench : cases) {
+        BenchResult result = {};
+        if (!runCase(bench, timeMs, result)) {
+            fprintf(stderr, "skipping %s %s %s: unknown engine or bad position\n",
+                    bench.game.c_str(), bench.engine.c_str(), bench.name.c_str());
+            failures++;
+            continue;
+        }
+
+        double nps = result.seconds > 0 ? result.nodes / result.seconds : 0.0;
+        if (json) {
+            printf("%s  {\"game\": \"%s\", \"engine\": \"%s\", \"name\": \"%s\", \"depth\": %d, \"nodes\": %llu, "
+                   "\"seconds\": %.6f, \"nps\": %.0f, \"branching\": %.3f, \"move\": %d, \"score\": %d}",
+                   first ? "" : ",\n", bench.game.c_str(), bench.engine.c_str(), bench.name.c_str(), result.depth,
+                   (unsigned long long)result.nodes, result.seconds, nps, result.branching, result.move, result.score);
+        } else {
+            printf("%s,%s,%s,%d,%llu,%.6f,%.0f,%.3f,%d,%d\n",
+                   bench.game.c_str(), bench.engine.c_str(), bench.name.c_str(), result.depth,
+                   (unsigned long long)result.nodes, result.seconds, nps, result.branching, result.move, result.score);
+        }
+        first = false;
+    }
+
+    if (json) {
+        printf("\n]\n");
+    }
+    return failures ? 1 : 0;
+}
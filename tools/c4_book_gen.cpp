@@ -0,0 +1,132 @@
+//
+// offline generator for the connect 4 opening book
+//
+// enumerates every position reachable in the first {ply} moves, solves the ones at
+// exactly {ply} moves with Connect4Solver (spread over all cores), then backs the
+// scores up move by move to the empty board, so only the deepest ply is ever solved
+//
+// usage: c4_book_gen [output=resources/connect4_book.bin] [ply=8] [threads=all cores]
+//
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "../classes/Connect4Book.h"
+#include "../classes/Connect4Search.h"
+#include "../classes/Connect4Solver.h"
+
+static const int MOVE_ORDER[7] = {3, 2, 4, 1, 5, 0, 6};
+
+struct BookPosition
+{
+    uint64_t myBoard;   // side to move
+    uint64_t oppBoard;
+    int      score;
+    int      column;
+};
+
+typedef std::unordered_map<uint64_t, BookPosition> PlyMap;
+
+int main(int argc, char **argv)
+{
+    std::string output = (argc > 1) ? argv[1] : Connect4Book::DEFAULT_FILE;
+    int maxPly = (argc > 2) ? atoi(argv[2]) : 8;
+    int threadCount = (argc > 3) ? atoi(argv[3]) : (int)std::thread::hardware_concurrency();
+    if (threadCount < 1) threadCount = 1;
+
+    // enumerate positions ply by ply, skipping games that are already won
+    std::vector<PlyMap> plies(maxPly + 1);
+    bool mirrored;
+    plies[0][Connect4Book::bookKey(0, 0, mirrored)] = BookPosition{0, 0, 0, -1};
+    for (int ply = 0; ply < maxPly; ply++) {
+        for (auto &item : plies[ply]) {
+            const BookPosition &pos = item.second;
+            for (int col = 0; col < 7; col++) {
+                uint64_t played = pos.myBoard;
+                if (!Connect4Search::playColumn(col, played, pos.oppBoard) || Connect4Search::isWin(played)) {
+                    continue;
+                }
+                uint64_t key = Connect4Book::bookKey(pos.oppBoard, played, mirrored);
+                plies[ply + 1].emplace(key, BookPosition{pos.oppBoard, played, 0, -1});
+            }
+        }
+        printf("ply %d: %zu positions\n", ply + 1, plies[ply + 1].size());
+    }
+
+    // solve the deepest ply in parallel, each thread with its own solver
+    std::vector<BookPosition *> work;
+    for (auto &item : plies[maxPly]) {
+        work.push_back(&item.second);
+    }
+
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> done(0);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([&]() {
+            Connect4Solver solver;
+            solver.setTimeBudget(24 * 60 * 60 * 1000);
+            for (size_t i = next++; i < work.size(); i = next++) {
+                BookPosition *pos = work[i];
+                pos->column = solver.bestMove(pos->myBoard, pos->oppBoard, pos->score);
+                size_t count = ++done;
+                if (count % 500 == 0) {
+                    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                    printf("solved %zu / %zu (%.0fs)\n", count, work.size(), seconds);
+                    fflush(stdout);
+                }
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    // back the scores up to the root, children one ply deeper are all known now
+    for (int ply = maxPly - 1; ply >= 0; ply--) {
+        for (auto &item : plies[ply]) {
+            BookPosition &pos = item.second;
+            pos.score = -100;
+            for (int col : MOVE_ORDER) {
+                uint64_t played = pos.myBoard;
+                if (!Connect4Search::playColumn(col, played, pos.oppBoard)) {
+                    continue;
+                }
+                int score;
+                if (Connect4Search::isWin(played)) {
+                    score = (43 - ply) / 2;
+                } else {
+                    score = -plies[ply + 1].at(Connect4Book::bookKey(pos.oppBoard, played, mirrored)).score;
+                }
+                if (score > pos.score) {
+                    pos.score = score;
+                    pos.column = col;
+                }
+            }
+        }
+    }
+
+    // the book stores the move for the canonical orientation
+    std::vector<Connect4Book::Record> records;
+    for (PlyMap &ply : plies) {
+        for (auto &item : ply) {
+            const BookPosition &pos = item.second;
+            Connect4Book::bookKey(pos.myBoard, pos.oppBoard, mirrored);
+            int column = mirrored ? 6 - pos.column : pos.column;
+            records.push_back(Connect4Book::Record{item.first, (int8_t)pos.score, (uint8_t)column});
+        }
+    }
+
+    if (!Connect4Book::write(output, maxPly, records)) {
+        fprintf(stderr, "couldn't write %s\n", output.c_str());
+        return 1;
+    }
+    printf("wrote %zu positions to %s, empty board scores %d\n", records.size(), output.c_str(), plies[0].begin()->second.score);
+    return 0;
+}
@@ -0,0 +1,110 @@
+//
+// compares the connect 4 leaf evaluators
+//
+// throughput: evaluates a fixed set of random positions with each evaluator
+// self-play:  EVAL_THREATS vs EVAL_LEGACY at a fixed depth, from every two-move opening
+//             with both colors, so the result doesn't depend on timing
+//
+// usage: c4_eval_bench [depth=8] [positions=200000]
+//
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "../classes/Connect4Search.h"
+
+struct Position
+{
+    uint64_t myBoard;
+    uint64_t oppBoard;
+};
+
+// random positions between 4 and 30 pieces with nobody already won
+static std::vector<Position> randomPositions(int count)
+{
+    std::mt19937_64 rng(42);
+    std::vector<Position> positions;
+    while ((int)positions.size() < count) {
+        Position pos = {0, 0};
+        int pieces = 4 + (int)(rng() % 27);
+        bool ok = true;
+        for (int i = 0; i < pieces && ok; i++) {
+            int col = (int)(rng() % 7);
+            ok = Connect4Search::playColumn(col, pos.myBoard, pos.oppBoard) && !Connect4Search::isWin(pos.myBoard);
+            std::swap(pos.myBoard, pos.oppBoard);
+        }
+        if (ok) {
+            positions.push_back(pos);
+        }
+    }
+    return positions;
+}
+
+static double evalsPerSecond(const std::vector<Position> &positions, int (*eval)(uint64_t, uint64_t), long long &checksum)
+{
+    const int rounds = 20;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (const Position &pos : positions) {
+            checksum += eval(pos.myBoard, pos.oppBoard);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return rounds * positions.size() / seconds;
+}
+
+// plays one game, returns 1 if the threat evaluator won, -1 if it lost, 0 for a draw
+static int playGame(Connect4Search &threats, Connect4Search &legacy, int first, int second, bool threatsIsRed)
+{
+    Connect4Position position;
+    position.play(first);
+    position.play(second);
+
+    while (!position.isFull()) {
+        bool threatsToMove = (position.playerToMove() == Connect4Position::RED) == threatsIsRed;
+        Connect4Search &search = threatsToMove ? threats : legacy;
+        position.play(search.findBestMove(position));
+        if (Connect4Search::isWin(position.opponent())) {
+            return threatsToMove ? 1 : -1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int depth = (argc > 1) ? atoi(argv[1]) : 8;
+    int count = (argc > 2) ? atoi(argv[2]) : 200000;
+
+    std::vector<Position> positions = randomPositions(count);
+    long long checksum = 0;
+    double legacyRate = evalsPerSecond(positions, Connect4Search::evalLegacy, checksum);
+    double threatsRate = evalsPerSecond(positions, Connect4Search::evalThreats, checksum);
+    printf("leaf evals/s: legacy %.1fM, threats %.1fM (checksum %lld)\n", legacyRate / 1e6, threatsRate / 1e6, checksum);
+
+    Connect4Search threats;
+    Connect4Search legacy;
+    for (Connect4Search *search : {&threats, &legacy}) {
+        search->setMaxDepth(depth);
+        search->setTimeBudget(24 * 60 * 60 * 1000);
+    }
+    threats.setEvalVersion(Connect4Search::EVAL_THREATS);
+    legacy.setEvalVersion(Connect4Search::EVAL_LEGACY);
+
+    int wins = 0, draws = 0, losses = 0;
+    for (int first = 0; first < 7; first++) {
+        for (int second = 0; second < 7; second++) {
+            for (bool threatsIsRed : {true, false}) {
+                int result = playGame(threats, legacy, first, second, threatsIsRed);
+                wins += result > 0;
+                draws += result == 0;
+                losses += result < 0;
+            }
+        }
+    }
+    int games = wins + draws + losses;
+    printf("self-play at depth %d, threats vs legacy: +%d =%d -%d (%.1f%%)\n", depth, wins, draws, losses,
+           100.0 * (wins + 0.5 * draws) / games);
+    return 0;
+}
@@ -0,0 +1,66 @@
+//
+// move ordering benchmark for the connect 4 search
+// searches a fixed set of positions to a fixed depth with the fixed center-out order
+// and with dynamic ordering, and reports nodes and how often the first move tried cuts off
+//
+// usage: c4_order_bench [depth]
+//
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include "../classes/Connect4Search.h"
+
+// positions as the columns played from the empty board, red moves first
+static const char *POSITIONS[] = {
+    "",
+    "3",
+    "33",
+    "3322",
+    "32415",
+    "334452",
+    "3332244",
+    "33221144",
+};
+
+int main(int argc, char **argv)
+{
+    int depth = (argc > 1) ? atoi(argv[1]) : 14;
+
+    printf("ordering,depth,positions,nodes,cutoffs,first_move_cutoff_rate,seconds\n");
+
+    for (bool dynamic : {false, true}) {
+        Connect4Search search;
+        search.setDynamicOrdering(dynamic);
+        search.setMaxDepth(depth);
+        search.setTimeBudget(1000 * 60 * 60);
+
+        uint64_t totalNodes = 0;
+        uint64_t totalCutoffs = 0;
+        uint64_t totalFirstMoveCutoffs = 0;
+        double totalSeconds = 0;
+        int positions = 0;
+
+        for (const char *moves : POSITIONS) {
+            Connect4Position position;
+            for (const char *c = moves; *c; c++) {
+                position.play(*c - '0');
+            }
+
+            // every position starts from an empty table, like it's the first one
+            search.clearTranspositionTable();
+            auto start = std::chrono::steady_clock::now();
+            search.findBestMove(position);
+            totalSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            totalNodes += search.getNodesSearched();
+            totalCutoffs += search.getCutoffs();
+            totalFirstMoveCutoffs += search.getFirstMoveCutoffs();
+            positions++;
+        }
+
+        printf("%s,%d,%d,%llu,%llu,%.3f,%.3f\n", dynamic ? "dynamic" : "static", depth, positions,
+               (unsigned long long)totalNodes, (unsigned long long)totalCutoffs,
+               totalCutoffs ? (double)totalFirstMoveCutoffs / totalCutoffs : 0.0, totalSeconds);
+    }
+    return 0;
+}
@@ -0,0 +1,68 @@
+//
+// scaling benchmark for the lazy SMP connect 4 search
+// searches a fixed set of positions to a fixed depth at 1, 2, 4 and 8 threads
+// and reports nodes per second and time to depth for each thread count
+//
+// usage: c4_smp_bench [depth]
+//
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include "../classes/Connect4Search.h"
+
+// positions as the columns played from the empty board, red moves first
+static const char *POSITIONS[] = {
+    "",
+    "3",
+    "33",
+    "3322",
+    "32415",
+    "334452",
+    "3332244",
+    "33221144",
+};
+
+int main(int argc, char **argv)
+{
+    int depth = (argc > 1) ? atoi(argv[1]) : 14;
+    const int threadCounts[] = {1, 2, 4, 8};
+
+    printf("threads,depth,positions,nodes,seconds,nps,avg_time_to_depth_ms,speedup\n");
+
+    double baseSeconds = 0;
+    for (int threads : threadCounts) {
+        Connect4Search search;
+        search.setThreads(threads);
+        search.setMaxDepth(depth);
+        search.setTimeBudget(1000 * 60 * 60);
+
+        uint64_t totalNodes = 0;
+        double totalSeconds = 0;
+        int positions = 0;
+
+        for (const char *moves : POSITIONS) {
+            Connect4Position position;
+            for (const char *c = moves; *c; c++) {
+                position.play(*c - '0');
+            }
+
+            // every position starts from an empty table, like it's the first one
+            search.clearTranspositionTable();
+            auto start = std::chrono::steady_clock::now();
+            search.findBestMove(position);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            totalNodes += search.getNodesSearched();
+            totalSeconds += seconds;
+            positions++;
+        }
+
+        if (threads == 1) {
+            baseSeconds = totalSeconds;
+        }
+        printf("%d,%d,%d,%llu,%.3f,%.0f,%.1f,%.2f\n",
+               threads, depth, positions, (unsigned long long)totalNodes, totalSeconds,
+               totalNodes / totalSeconds, 1000.0 * totalSeconds / positions, baseSeconds / totalSeconds);
+    }
+    return 0;
+}
@@ -0,0 +1,337 @@
+//
+// builds the checkers endgame database (classes/CheckersEndgame.h) by retrograde analysis
+//
+// slices are solved from the fewest pieces up, and within a piece count from the fewest men
+// up, so a capture or a crowning always leads into a slice that's already done. the only
+// slice a plain move can lead to is the same material with the colors swapped, so each
+// slice is solved together with its mirror: every pass looks at the positions that are
+// still open and calls one a win if a move reaches a loss for the opponent, a loss if every
+// move reaches a win (or there's no move at all). passes run until one changes nothing,
+// and whatever is still open then can be held forever by both sides, which is a draw.
+// every pass is split across all cores.
+// each finished slice is saved to the work directory straight away, and slices already
+// there are loaded instead of solved again, so an interrupted build picks up where it
+// stopped. the database file is written from them at the end
+//
+// usage: checkers_egdb [output=resources/checkers_endgame.bin] [--pieces N] [--threads N] [--work DIR]
+//
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../classes/CheckersEndgame.h"
+#include "../classes/CheckersPosition.h"
+
+// states of a position while its slice is being solved, the first three match CheckersEndgame::Value
+static const uint8_t DRAW = CheckersEndgame::DRAW;
+static const uint8_t WIN = CheckersEndgame::WIN;
+static const uint8_t LOSS = CheckersEndgame::LOSS;
+static const uint8_t OPEN = 3;
+static const uint8_t INVALID = 4;   // an index no position has
+
+static const int CHUNK = 4096;      // positions a thread takes at a time
+static const int KIND_SIZE = CheckersEndgame::MAX_PIECES + 1;
+
+struct Slice
+{
+    int     redMen, redKings, yellowMen, yellowKings;
+
+    int     pieces() const { return redMen + redKings + yellowMen + yellowKings; }
+    Slice   mirror() const { return {yellowMen, yellowKings, redMen, redKings}; }
+    bool    operator==(const Slice &other) const
+    {
+        return redMen == other.redMen && redKings == other.redKings &&
+               yellowMen == other.yellowMen && yellowKings == other.yellowKings;
+    }
+    uint64_t size() const { return CheckersEndgame::sliceSize(redMen, redKings, yellowMen, yellowKings); }
+    std::string name() const
+    {
+        return std::to_string(redMen) + "-" + std::to_string(redKings) + "-" +
+               std::to_string(yellowMen) + "-" + std::to_string(yellowKings);
+    }
+};
+
+// a slice being solved
+struct Work
+{
+    Slice   slice;
+    uint64_t size;
+    std::unique_ptr<std::atomic<uint8_t>[]> values;
+};
+
+// every finished slice, by piece counts
+static std::vector<const CheckersEndgame::Table *> finished(KIND_SIZE * KIND_SIZE * KIND_SIZE * KIND_SIZE, nullptr);
+
+static int sliceKey(int redMen, int redKings, int yellowMen, int yellowKings)
+{
+    return ((redMen * KIND_SIZE + redKings) * KIND_SIZE + yellowMen) * KIND_SIZE + yellowKings;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// run {body} on every index below {count}, a chunk at a time on every thread
+template <typename Body>
+static void parallelFor(uint64_t count, int threadCount, Body body)
+{
+    std::atomic<uint64_t> next(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([&]() {
+            for (uint64_t start = next.fetch_add(CHUNK); start < count; start = next.fetch_add(CHUNK)) {
+                uint64_t end = std::min<uint64_t>(start + CHUNK, count);
+                for (uint64_t i = start; i < end; i++) {
+                    body(i);
+                }
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+//
+// the value of the position after a move, for the opponent who's now to move. it's turned
+// round so they're red, and looked up in the slices being solved or the ones already done
+//
+static int successorValue(const CheckersPosition &position, Work *work, int workCount)
+{
+    uint32_t red = CheckersEndgame::flip(position.pieces(CheckersPosition::YELLOW));
+    uint32_t yellow = CheckersEndgame::flip(position.pieces(CheckersPosition::RED));
+    uint32_t kings = CheckersEndgame::flip(position.kings());
+    if (!red) {
+        return LOSS;    // nothing left to move
+    }
+
+    int redKings = std::popcount(red & kings);
+    int yellowKings = std::popcount(yellow & kings);
+    Slice slice = {std::popcount(red) - redKings, redKings, std::popcount(yellow) - yellowKings, yellowKings};
+    uint64_t index;
+    CheckersEndgame::index(red, yellow, kings, index);
+
+    for (int w = 0; w < workCount; w++) {
+        if (work[w].slice == slice) {
+            return work[w].values[index].load(std::memory_order_relaxed);
+        }
+    }
+    const CheckersEndgame::Table *table = finished[sliceKey(slice.redMen, slice.redKings, slice.yellowMen, slice.yellowKings)];
+    return CheckersEndgame::packedValue(table->packed, index);
+}
+
+static bool loadTable(const std::filesystem::path &path, CheckersEndgame::Table &table)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    file.read(reinterpret_cast<char *>(table.packed.data()), table.packed.size());
+    return file.gcount() == (std::streamsize)table.packed.size() && file.peek() == EOF;
+}
+
+static bool saveTable(const std::filesystem::path &path, const CheckersEndgame::Table &table)
+{
+    // written under another name first, so a build killed halfway never leaves a short file
+    std::filesystem::path partial = path;
+    partial += ".partial";
+    {
+        std::ofstream file(partial, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(table.packed.data()), table.packed.size());
+        if (!file) return false;
+    }
+    std::error_code error;
+    std::filesystem::rename(partial, path, error);
+    return !error;
+}
+
+// solve a slice and its mirror together, {workCount} is 1 when the slice is its own mirror
+static void solve(Work *work, int workCount, int threadCount, int &passes)
+{
+    // positions with no index are left out of everything
+    for (int w = 0; w < workCount; w++) {
+        Work &slice = work[w];
+        parallelFor(slice.size, threadCount, [&](uint64_t i) {
+            uint32_t red, yellow, kings;
+            bool valid = CheckersEndgame::unindex(slice.slice.redMen, slice.slice.redKings, slice.slice.yellowMen,
+                                                  slice.slice.yellowKings, i, red, yellow, kings);
+            slice.values[i].store(valid ? OPEN : INVALID, std::memory_order_relaxed);
+        });
+    }
+
+    for (passes = 1;; passes++) {
+        std::atomic<bool> changed(false);
+        for (int w = 0; w < workCount; w++) {
+            Work &slice = work[w];
+            parallelFor(slice.size, threadCount, [&](uint64_t i) {
+                if (slice.values[i].load(std::memory_order_relaxed) != OPEN) return;
+
+                thread_local std::vector<CheckersPosition::Move> moves;
+                uint32_t red, yellow, kings;
+                CheckersEndgame::unindex(slice.slice.redMen, slice.slice.redKings, slice.slice.yellowMen,
+                                         slice.slice.yellowKings, i, red, yellow, kings);
+                CheckersPosition position;
+                position.setPieces(red, yellow, kings, CheckersPosition::RED);
+                position.generateMoves(moves);
+
+                uint8_t result = LOSS;  // until a move says otherwise
+                for (const CheckersPosition::Move &move : moves) {
+                    position.play(move);
+                    int value = successorValue(position, work, workCount);
+                    position.undo(move);
+                    if (value == LOSS) {
+                        result = WIN;
+                        break;
+                    }
+                    if (value != WIN) {
+                        result = OPEN;
+                    }
+                }
+                if (result != OPEN) {
+                    slice.values[i].store(result, std::memory_order_relaxed);
+                    changed = true;
+                }
+            });
+        }
+        if (!changed) {
+            break;
+        }
+    }
+}
+
+// the solved values packed 4 to a byte, with the indices no position has copying the value
+// before them so they don't break up the runs
+static void pack(const Work &work, CheckersEndgame::Table &table)
+{
+    uint8_t last = DRAW;
+    for (uint64_t i = 0; i < work.size; i++) {
+        uint8_t value = work.values[i].load(std::memory_order_relaxed);
+        if (value == OPEN) value = DRAW;
+        if (value == INVALID) value = last;
+        last = value;
+        table.packed[i >> 2] |= (uint8_t)(value << ((i & 3) * 2));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string output = CheckersEndgame::DEFAULT_FILE;
+    std::filesystem::path workDirectory = "checkers_egdb_work";
+    int maxPieces = 4;
+    int threadCount = (int)std::thread::hardware_concurrency();
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--pieces" && hasValue) maxPieces = atoi(argv[++i]);
+        else if (arg == "--threads" && hasValue) threadCount = atoi(argv[++i]);
+        else if (arg == "--work" && hasValue) workDirectory = argv[++i];
+        else if (arg[0] != '-') output = arg;
+        else {
+            fprintf(stderr, "usage: checkers_egdb [output] [--pieces N] [--threads N] [--work DIR]\n");
+            return 1;
+        }
+    }
+    if (maxPieces < 2 || maxPieces > CheckersEndgame::MAX_PIECES) {
+        fprintf(stderr, "--pieces has to be from 2 to %d\n", CheckersEndgame::MAX_PIECES);
+        return 1;
+    }
+    threadCount = std::max(1, threadCount);
+    std::filesystem::create_directories(workDirectory);
+
+    //
+    // every slice in the order they depend on each other
+    //
+    std::vector<Slice> order;
+    for (int pieces = 2; pieces <= maxPieces; pieces++) {
+        for (int men = 0; men <= pieces; men++) {
+            for (int redMen = 0; redMen <= men; redMen++) {
+                for (int redKings = 0; redKings <= pieces - men; redKings++) {
+                    Slice slice = {redMen, redKings, men - redMen, pieces - men - redKings};
+                    if (slice.redMen + slice.redKings > 0 && slice.yellowMen + slice.yellowKings > 0) {
+                        order.push_back(slice);
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<CheckersEndgame::Table>> tables;
+    auto start = std::chrono::steady_clock::now();
+    uint64_t totalPositions = 0;
+    for (const Slice &slice : order) {
+        if (finished[sliceKey(slice.redMen, slice.redKings, slice.yellowMen, slice.yellowKings)]) {
+            continue;   // done along with its mirror
+        }
+
+        Slice slices[2] = {slice, slice.mirror()};
+        int count = (slice.mirror() == slice) ? 1 : 2;
+        std::unique_ptr<CheckersEndgame::Table> solved[2];
+        bool loaded = true;
+        for (int s = 0; s < count; s++) {
+            solved[s] = std::make_unique<CheckersEndgame::Table>();
+            CheckersEndgame::Table &table = *solved[s];
+            table.redMen = slices[s].redMen;
+            table.redKings = slices[s].redKings;
+            table.yellowMen = slices[s].yellowMen;
+            table.yellowKings = slices[s].yellowKings;
+            table.packed.assign((slices[s].size() + 3) / 4, 0);
+            loaded = loadTable(workDirectory / (slices[s].name() + ".bin"), table) && loaded;
+        }
+
+        auto sliceStart = std::chrono::steady_clock::now();
+        uint64_t positions = 0;
+        int passes = 0;
+        if (!loaded) {
+            Work work[2];
+            for (int s = 0; s < count; s++) {
+                work[s].slice = slices[s];
+                work[s].size = slices[s].size();
+                work[s].values = std::make_unique<std::atomic<uint8_t>[]>(work[s].size);
+                positions += work[s].size;
+            }
+            solve(work, count, threadCount, passes);
+
+            for (int s = 0; s < count; s++) {
+                std::fill(solved[s]->packed.begin(), solved[s]->packed.end(), 0);
+                pack(work[s], *solved[s]);
+                if (!saveTable(workDirectory / (slices[s].name() + ".bin"), *solved[s])) {
+                    fprintf(stderr, "couldn't save %s to %s\n", slices[s].name().c_str(), workDirectory.string().c_str());
+                    return 1;
+                }
+            }
+        }
+
+        for (int s = 0; s < count; s++) {
+            finished[sliceKey(slices[s].redMen, slices[s].redKings, slices[s].yellowMen, slices[s].yellowKings)] = solved[s].get();
+            tables.push_back(std::move(solved[s]));
+        }
+        totalPositions += positions;
+        if (loaded) {
+            printf("%s: loaded\n", slice.name().c_str());
+        } else {
+            printf("%s: %llu positions, %d passes, %.1fs\n", slice.name().c_str(), (unsigned long long)positions,
+                   passes, secondsSince(sliceStart));
+        }
+        fflush(stdout);
+    }
+
+    std::vector<CheckersEndgame::Table> all;
+    all.reserve(tables.size());
+    for (const auto &table : tables) {
+        all.push_back(std::move(*table));
+    }
+    if (!CheckersEndgame::write(output, maxPieces, all)) {
+        fprintf(stderr, "couldn't write %s\n", output.c_str());
+        return 1;
+    }
+    printf("solved %llu positions, wrote %s (%llu bytes) in %.0fs\n", (unsigned long long)totalPositions, output.c_str(),
+           (unsigned long long)std::filesystem::file_size(output), secondsSince(start));
+    return 0;
+}
@@ -0,0 +1,233 @@
+//
+// fits the othello pattern weights (classes/OthelloPatterns.h) to self-play games
+//
+// every game opens with a few random moves so no two are alike, then OthelloSearch plays
+// both sides at a fixed depth until SOLVE_EMPTIES squares are left, where OthelloSolver
+// takes over and plays the rest perfectly. every position of the game is labeled with the
+// solver's exact result, as black's final disc difference.
+// the weights are then fitted by stochastic gradient descent on the squared error, one
+// set of tables per stage, with every tenth game held out to check the fit against.
+// the search plays with the hand-tuned evaluation, or with --weights from an earlier run,
+// so each round of training can play better games for the next
+//
+// usage: othello_train [output=resources/othello_weights.bin] [--games N] [--depth N]
+//                      [--random-plies N] [--epochs N] [--weights FILE] [--threads N] [--seed N]
+//
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../classes/OthelloPatterns.h"
+#include "../classes/OthelloPosition.h"
+#include "../classes/OthelloSearch.h"
+#include "../classes/OthelloSolver.h"
+
+static const int SOLVE_EMPTIES = 14;
+
+struct Sample
+{
+    OthelloPatterns::Features features;
+    uint8_t  stage;
+    int8_t   score;     // black's final disc difference
+};
+
+// where each instance's table starts, looked up once instead of on every weight
+static int OFFSETS[OthelloPatterns::INSTANCES];
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// one self-play game, its positions go in {samples}
+static void playGame(OthelloSearch &search, OthelloSolver &solver, std::mt19937 &rng, int randomPlies,
+                     std::vector<Sample> &samples)
+{
+    OthelloPosition position;
+    std::vector<OthelloPosition> played;
+
+    int ply = 0;
+    int score = 0;
+    bool solved = false;
+    while (!position.isGameOver()) {
+        played.push_back(position);
+        int square;
+        if (position.mustPass()) {
+            square = -1;
+        } else if (ply < randomPlies) {
+            uint64_t moves = position.legalMoves();
+            for (int skip = (int)(rng() % std::popcount(moves)); skip > 0; skip--) {
+                moves &= moves - 1;
+            }
+            square = std::countr_zero(moves);
+        } else if (position.emptyCount() <= SOLVE_EMPTIES) {
+            int solverScore;
+            square = solver.bestMove(position, solverScore);
+            if (!solved) {
+                // perfect play from here on keeps the score where it is
+                score = (position.playerToMove() == OthelloPosition::BLACK) ? solverScore : -solverScore;
+                solved = true;
+            }
+        } else {
+            square = search.findBestMove(position);
+        }
+
+        if (square < 0) position.pass();
+        else position.play(square);
+        ply++;
+    }
+    if (!solved) {
+        score = OthelloSolver::finalScore(position.board(OthelloPosition::BLACK), position.board(OthelloPosition::WHITE));
+    }
+
+    for (const OthelloPosition &at : played) {
+        Sample sample;
+        sample.features.set(at.board(OthelloPosition::BLACK), at.board(OthelloPosition::WHITE));
+        sample.stage = (uint8_t)OthelloPatterns::stage(OthelloPosition::SQUARES - at.emptyCount());
+        sample.score = (int8_t)score;
+        samples.push_back(sample);
+    }
+}
+
+static float predict(const std::vector<float> &weights, const Sample &sample)
+{
+    const float *stage = weights.data() + (size_t)sample.stage * OthelloPatterns::STAGE_SIZE;
+    float sum = 0.0f;
+    for (int i = 0; i < OthelloPatterns::INSTANCES; i++) {
+        sum += stage[OFFSETS[i] + sample.features.index[i]];
+    }
+    return sum;
+}
+
+// root mean square error in discs
+static double rmsError(const std::vector<float> &weights, const std::vector<Sample> &samples)
+{
+    double total = 0.0;
+    for (const Sample &sample : samples) {
+        double error = sample.score - predict(weights, sample);
+        total += error * error;
+    }
+    return samples.empty() ? 0.0 : std::sqrt(total / samples.size());
+}
+
+int main(int argc, char **argv)
+{
+    std::string output = OthelloPatterns::DEFAULT_FILE;
+    std::string weightsFile;
+    int games = 20000;
+    int depth = 4;
+    int randomPlies = 10;
+    int epochs = 20;
+    int threadCount = (int)std::thread::hardware_concurrency();
+    unsigned seed = 1;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--games" && hasValue) games = atoi(argv[++i]);
+        else if (arg == "--depth" && hasValue) depth = atoi(argv[++i]);
+        else if (arg == "--random-plies" && hasValue) randomPlies = atoi(argv[++i]);
+        else if (arg == "--epochs" && hasValue) epochs = atoi(argv[++i]);
+        else if (arg == "--weights" && hasValue) weightsFile = argv[++i];
+        else if (arg == "--threads" && hasValue) threadCount = atoi(argv[++i]);
+        else if (arg == "--seed" && hasValue) seed = (unsigned)atoi(argv[++i]);
+        else if (arg[0] != '-') output = arg;
+        else {
+            fprintf(stderr, "usage: othello_train [output] [--games N] [--depth N] [--random-plies N] [--epochs N] "
+                            "[--weights FILE] [--threads N] [--seed N]\n");
+            return 1;
+        }
+    }
+    if (threadCount < 1) threadCount = 1;
+    for (int i = 0; i < OthelloPatterns::INSTANCES; i++) {
+        OFFSETS[i] = OthelloPatterns::tableOffset(i);
+    }
+
+    // one mapping of the weights serves every thread's search
+    OthelloPatterns patterns;
+    if (!weightsFile.empty() && !patterns.open(weightsFile)) {
+        fprintf(stderr, "couldn't load weights from %s\n", weightsFile.c_str());
+        return 1;
+    }
+
+    //
+    // self-play, each game seeded on its own so the games don't depend on the thread count
+    //
+    std::vector<std::vector<Sample>> gameSamples(games);
+    std::atomic<int> next(0);
+    std::atomic<int> done(0);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([&]() {
+            OthelloSearch search;
+            search.setPatterns(&patterns);
+            search.setMaxDepth(depth);
+            search.setTimeBudget(24 * 60 * 60 * 1000);
+            search.setEndgameEmpties(0);
+            search.setTranspositionTableSize(16);
+            OthelloSolver solver;
+            for (int game = next++; game < games; game = next++) {
+                std::mt19937 rng(seed * 1000003u + (unsigned)game);
+                search.clearTranspositionTable();
+                playGame(search, solver, rng, randomPlies, gameSamples[game]);
+                int count = ++done;
+                if (count % 1000 == 0) {
+                    printf("played %d / %d games (%.0fs)\n", count, games, secondsSince(start));
+                    fflush(stdout);
+                }
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    std::vector<Sample> training, test;
+    for (int game = 0; game < games; game++) {
+        std::vector<Sample> &into = (game % 10 == 9) ? test : training;
+        into.insert(into.end(), gameSamples[game].begin(), gameSamples[game].end());
+    }
+    gameSamples.clear();
+    printf("%zu training positions, %zu test positions\n", training.size(), test.size());
+
+    //
+    // fit, with the step shrinking a little every epoch
+    //
+    std::vector<float> weights((size_t)OthelloPatterns::STAGES * OthelloPatterns::STAGE_SIZE, 0.0f);
+    std::mt19937 shuffle(seed);
+    float rate = 0.001f;
+    for (int epoch = 1; epoch <= epochs; epoch++) {
+        std::shuffle(training.begin(), training.end(), shuffle);
+        for (const Sample &sample : training) {
+            float step = rate * (sample.score - predict(weights, sample));
+            float *stage = weights.data() + (size_t)sample.stage * OthelloPatterns::STAGE_SIZE;
+            for (int i = 0; i < OthelloPatterns::INSTANCES; i++) {
+                stage[OFFSETS[i] + sample.features.index[i]] += step;
+            }
+        }
+        rate *= 0.85f;
+        printf("epoch %d: training error %.2f discs, test error %.2f discs\n",
+               epoch, rmsError(weights, training), rmsError(weights, test));
+        fflush(stdout);
+    }
+
+    // hundredths of a disc, the way OthelloPatterns::evaluate adds them up
+    std::vector<int16_t> scaled(weights.size());
+    for (size_t i = 0; i < weights.size(); i++) {
+        scaled[i] = (int16_t)std::clamp(std::lround(weights[i] * 100.0f), -32767L, 32767L);
+    }
+    if (!OthelloPatterns::write(output, scaled)) {
+        fprintf(stderr, "couldn't write %s\n", output.c_str());
+        return 1;
+    }
+    printf("wrote %s in %.0fs\n", output.c_str(), secondsSince(start));
+    return 0;
+}
@@ -0,0 +1,399 @@
+//
+// perft: counts the move sequences of a given length from a position, to check the move
+// generators against known counts and to time them
+//
+// positions are the move generators in the gameengine library, which the games use for
+// their rules. a finished game has no moves, so it adds nothing to the count past its end,
+// except in othello: there a side with no move passes, and that counts as a move even once
+// the game is over, like in the published counts
+//
+// usage: perft                            check every reference count, exits 1 on a mismatch
+//        perft <game>                     the reference counts for one game
+//        perft <game> <depth> [position [side]] [--divide]
+//
+// positions are written as
+//   connect4    the columns played from the empty board, "-" for the empty board
+//   othello     the 64 character state string, then b or w for the side to move
+//               (othello-string runs the same count on the OthelloRules string generator)
+//   checkers    the 32 character state string, then r or y for the side to move
+//   tictactoe   the 9 character state string, the side to move follows from the piece count
+// --divide prints the count under every first move, to narrow a mismatch down to one line
+//
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../classes/CheckersPosition.h"
+#include "../classes/Connect4Search.h"
+#include "../classes/OthelloPosition.h"
+#include "../classes/OthelloRules.h"
+#include "../classes/TicTacToePosition.h"
+
+// moves generated over the whole run, for the throughput figure
+static uint64_t movesGenerated = 0;
+
+//
+// connect 4
+//
+static uint64_t perftConnect4(Connect4Position &position, int depth)
+{
+    if (depth == 0) return 1;
+    if (Connect4Search::isWin(position.opponent())) return 0;
+
+    uint64_t count = 0;
+    for (int col = 0; col < Connect4Position::WIDTH; col++) {
+        if (!position.canPlay(col)) continue;
+        movesGenerated++;
+        position.play(col);
+        count += perftConnect4(position, depth - 1);
+        position.undo();
+    }
+    return count;
+}
+
+//
+// othello, on the bitboard position
+//
+static uint64_t perftOthello(OthelloPosition &position, int depth)
+{
+    if (depth == 0) return 1;
+
+    uint64_t moves = position.legalMoves();
+    if (!moves) {
+        movesGenerated++;
+        position.pass();
+        uint64_t count = perftOthello(position, depth - 1);
+        position.pass();
+        return count;
+    }
+
+    // the last ply only needs the number of moves
+    if (depth == 1) {
+        movesGenerated += std::popcount(moves);
+        return std::popcount(moves);
+    }
+
+    uint64_t count = 0;
+    for (; moves; moves &= moves - 1) {
+        int square = std::countr_zero(moves);
+        movesGenerated++;
+        uint64_t flipped = position.play(square);
+        count += perftOthello(position, depth - 1);
+        position.undo(square, flipped);
+    }
+    return count;
+}
+
+//
+// othello on the state string, the old generator, kept to check the bitboards against
+//
+struct OthelloState
+{
+    std::string board;
+    char        piece;
+};
+
+// every legal square, or a single -1 for a pass
+static void othelloStringMoves(const OthelloState &state, std::vector<int> &moves)
+{
+    moves.clear();
+    for (int square = 0; square < 64; square++) {
+        if (OthelloRules::isValidMove(state.board, square % 8, square / 8, state.piece)) {
+            moves.push_back(square);
+        }
+    }
+    if (moves.empty()) {
+        moves.push_back(-1);
+    }
+}
+
+static uint64_t perftOthelloString(const OthelloState &state, int depth)
+{
+    if (depth == 0) return 1;
+
+    std::vector<int> moves;
+    othelloStringMoves(state, moves);
+    movesGenerated += moves.size();
+
+    uint64_t count = 0;
+    for (int square : moves) {
+        OthelloState next = state;
+        if (square >= 0) {
+            OthelloRules::playMove(next.board, square % 8, square / 8, next.piece);
+        }
+        next.piece = OthelloRules::opponent(next.piece);
+        count += perftOthelloString(next, depth - 1);
+    }
+    return count;
+}
+
+//
+// checkers
+//
+static uint64_t perftCheckers(CheckersPosition &position, int depth)
+{
+    if (depth == 0) return 1;
+
+    std::vector<CheckersPosition::Move> moves;
+    position.generateMoves(moves);
+    movesGenerated += moves.size();
+
+    uint64_t count = 0;
+    for (const CheckersPosition::Move &move : moves) {
+        position.play(move);
+        count += perftCheckers(position, depth - 1);
+        position.undo(move);
+    }
+    return count;
+}
+
+//
+// tic tac toe
+//
+static uint64_t perftTicTacToe(TicTacToePosition &position, int depth)
+{
+    if (depth == 0) return 1;
+    if (position.winner() >= 0) return 0;
+
+    uint64_t count = 0;
+    for (int square = 0; square < TicTacToePosition::SQUARES; square++) {
+        if (!position.canPlay(square)) continue;
+        movesGenerated++;
+        position.play(square);
+        count += perftTicTacToe(position, depth - 1);
+        position.undo();
+    }
+    return count;
+}
+
+//
+// parsing positions and running one count, optionally divided by the first move
+//
+static bool parseConnect4(const std::string &text, Connect4Position &position)
+{
+    if (text == "-") return true;
+    for (char c : text) {
+        int col = c - '0';
+        if (col < 0 || col >= Connect4Position::WIDTH || !position.canPlay(col)) return false;
+        position.play(col);
+    }
+    return true;
+}
+
+static bool parseTicTacToe(const std::string &text, TicTacToePosition &position)
+{
+    if (text.length() != TicTacToePosition::SQUARES) return false;
+    for (int square = 0; square < TicTacToePosition::SQUARES; square++) {
+        if (text[square] == '1' || text[square] == '2') {
+            position.setPiece(square, text[square] - '1');
+        }
+    }
+    return true;
+}
+
+// returns false if the position doesn't parse
+static bool runPerft(const std::string &game, const std::string &text, const std::string &side, int depth,
+                     bool divide, uint64_t &count)
+{
+    count = 0;
+    if (game == "connect4") {
+        Connect4Position position;
+        if (!parseConnect4(text, position)) return false;
+        if (!divide || depth == 0) {
+            count = perftConnect4(position, depth);
+            return true;
+        }
+        for (int col = 0; col < Connect4Position::WIDTH; col++) {
+            if (!position.canPlay(col) || Connect4Search::isWin(position.opponent())) continue;
+            position.play(col);
+            uint64_t moveCount = perftConnect4(position, depth - 1);
+            position.undo();
+            printf("  %d: %llu\n", col, (unsigned long long)moveCount);
+            count += moveCount;
+        }
+        return true;
+    }
+
+    if (game == "othello") {
+        OthelloPosition position;
+        if (!position.setState(text, side == "w" ? OthelloPosition::WHITE : OthelloPosition::BLACK)) return false;
+        if (!divide || depth == 0) {
+            count = perftOthello(position, depth);
+            return true;
+        }
+        uint64_t moves = position.legalMoves();
+        if (!moves) {
+            position.pass();
+            count = perftOthello(position, depth - 1);
+            printf("  pass: %llu\n", (unsigned long long)count);
+            return true;
+        }
+        for (; moves; moves &= moves - 1) {
+            int square = std::countr_zero(moves);
+            uint64_t flipped = position.play(square);
+            uint64_t moveCount = perftOthello(position, depth - 1);
+            position.undo(square, flipped);
+            printf("  %c%d: %llu\n", 'a' + square % 8, square / 8 + 1, (unsigned long long)moveCount);
+            count += moveCount;
+        }
+        return true;
+    }
+
+    if (game == "othello-string") {
+        if (text.length() != 64) return false;
+        OthelloState state = {text, side == "w" ? OthelloRules::WHITE : OthelloRules::BLACK};
+        count = perftOthelloString(state, depth);
+        return true;
+    }
+
+    if (game == "checkers") {
+        CheckersPosition position;
+        if (text != "-" && !position.setState(text, side == "y" ? CheckersPosition::YELLOW : CheckersPosition::RED)) {
+            return false;
+        }
+        if (!divide || depth == 0) {
+            count = perftCheckers(position, depth);
+            return true;
+        }
+        std::vector<CheckersPosition::Move> moves;
+        position.generateMoves(moves);
+        for (const CheckersPosition::Move &move : moves) {
+            position.play(move);
+            uint64_t moveCount = perftCheckers(position, depth - 1);
+            position.undo(move);
+            printf("  %d", move.from);
+            for (int i = 0; i < move.jumps; i++) {
+                printf("x%d", move.path[i]);
+            }
+            if (move.jumps == 0) {
+                printf("-%d", move.to);
+            }
+            printf(": %llu\n", (unsigned long long)moveCount);
+            count += moveCount;
+        }
+        return true;
+    }
+
+    if (game == "tictactoe") {
+        TicTacToePosition position;
+        if (text != "-" && !parseTicTacToe(text, position)) return false;
+        if (!divide || depth == 0) {
+            count = perftTicTacToe(position, depth);
+            return true;
+        }
+        for (int square = 0; square < TicTacToePosition::SQUARES; square++) {
+            if (!position.canPlay(square) || position.winner() >= 0) continue;
+            position.play(square);
+            uint64_t moveCount = perftTicTacToe(position, depth - 1);
+            position.undo();
+            printf("  %d: %llu\n", square, (unsigned long long)moveCount);
+            count += moveCount;
+        }
+        return true;
+    }
+    return false;
+}
+
+//
+// reference counts. the opening counts for othello and checkers are the published ones,
+// the rest were cross-checked against a plain array implementation of the rules
+//
+struct Reference
+{
+    const char *game;
+    const char *name;
+    const char *position;
+    const char *side;
+    int         depth;
+    uint64_t    expected;
+};
+
+static const Reference REFERENCES[] = {
+    {"connect4",  "start",      "-",            "", 1, 7},
+    {"connect4",  "start",      "-",            "", 4, 2401},
+    {"connect4",  "start",      "-",            "", 6, 117649},
+    {"connect4",  "start",      "-",            "", 8, 5673234},
+    {"connect4",  "midgame",    "3332224",      "", 7, 746864},
+    {"connect4",  "full-cols",  "333333444444", "", 6, 10345},
+
+    {"othello",   "start", "0000000000000000000000000002100000012000000000000000000000000000", "b", 1, 4},
+    {"othello",   "start", "0000000000000000000000000002100000012000000000000000000000000000", "b", 3, 56},
+    {"othello",   "start", "0000000000000000000000000002100000012000000000000000000000000000", "b", 5, 1396},
+    {"othello",   "start", "0000000000000000000000000002100000012000000000000000000000000000", "b", 7, 55092},
+    {"othello",   "start", "0000000000000000000000000002100000012000000000000000000000000000", "b", 8, 390216},
+    {"othello",   "start", "0000000000000000000000000002100000012000000000000000000000000000", "b", 9, 3005288},
+    {"othello",   "start", "0000000000000000000000000002100000012000000000000000000000000000", "b", 10, 24571284},
+    {"othello-string", "start", "0000000000000000000000000002100000012000000000000000000000000000", "b", 6, 8200},
+
+    {"checkers",  "start",  "-", "r", 1, 7},
+    {"checkers",  "start",  "-", "r", 4, 1469},
+    {"checkers",  "start",  "-", "r", 6, 36768},
+    {"checkers",  "start",  "-", "r", 8, 845931},
+    {"checkers",  "kings",  "00010000041010001303003000333003", "r", 7, 68147},
+    {"checkers",  "endgame", "40000000100110000003210000000000", "r", 7, 18817},
+
+    {"tictactoe", "start",  "-",         "", 5, 15120},
+    {"tictactoe", "start",  "-",         "", 6, 54720},
+    {"tictactoe", "start",  "-",         "", 9, 127872},
+    {"tictactoe", "corner", "100000000", "", 8, 13968},
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static int runReferences(const std::string &game)
+{
+    int failures = 0;
+    printf("game,name,depth,count,expected,result,seconds,moves_per_second\n");
+    for (const Reference &reference : REFERENCES) {
+        if (!game.empty() && game != reference.game) continue;
+
+        movesGenerated = 0;
+        uint64_t count;
+        auto start = Clock::now();
+        bool parsed = runPerft(reference.game, reference.position, reference.side, reference.depth, false, count);
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        bool ok = parsed && count == reference.expected;
+        failures += !ok;
+        printf("%s,%s,%d,%llu,%llu,%s,%.6f,%.0f\n", reference.game, reference.name, reference.depth,
+               (unsigned long long)count, (unsigned long long)reference.expected, ok ? "ok" : "MISMATCH",
+               seconds, seconds > 0 ? movesGenerated / seconds : 0.0);
+    }
+    return failures;
+}
+
+int main(int argc, char **argv)
+{
+    bool divide = false;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--divide") == 0) divide = true;
+        else args.push_back(argv[i]);
+    }
+
+    if (args.size() < 2) {
+        return runReferences(args.empty() ? "" : args[0]) ? 1 : 0;
+    }
+
+    std::string game = args[0];
+    int depth = atoi(args[1].c_str());
+    std::string position = args.size() > 2 ? args[2] : "-";
+    std::string side = args.size() > 3 ? args[3] : "";
+    if (game.compare(0, 7, "othello") == 0 && position == "-") {
+        position = OthelloRules::initialState();
+    }
+
+    uint64_t count;
+    auto start = Clock::now();
+    if (!runPerft(game, position, side, depth, divide, count)) {
+        fprintf(stderr, "unknown game or bad position\n");
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    printf("%s depth %d: %llu (%.3fs, %.0f moves/s)\n", game.c_str(), depth, (unsigned long long)count, seconds,
+           seconds > 0 ? movesGenerated / seconds : 0.0);
+    return 0;
+}
@@ -0,0 +1,449 @@
+//
+// headless self-play tournament between two engine configurations
+//
+// plays a match of connect 4, othello or checkers games across all cores. every opening is a few
+// random moves and gets played twice with the colors swapped, so neither side gets the
+// better openings. reports win/draw/loss, an elo difference with a 95% confidence
+// interval and the average time each side took per move
+//
+// engines are written as a kind followed by comma separated settings:
+//   connect4:  search[,depth=N][,time=MS][,threads=N][,eval=threats|legacy][,ordering=dynamic|static]
+//              solver[,time=MS]    the solver falls back on a random move when it runs out of time
+//              mcts[,time=MS][,threads=N]
+//              random
+//   othello:   search[,depth=N][,time=MS][,endgame=N][,weights=FILE]
+//              solves exactly from N empties (0 never does), evaluates with the pattern weights in FILE
+//              mcts[,time=MS][,threads=N]
+//              greedy
+//              random
+//   checkers:  search[,depth=N][,time=MS][,egdb=FILE]
+//              looks endgames up in the database in FILE
+//              mcts[,time=MS][,threads=N]
+//              random
+//   mcts is monte carlo tree search, keeping its tree from one move to the next
+//   a checkers game with no capture and no man moved for DRAW_PLIES plies is a draw
+//
+// usage: tournament <connect4|othello|checkers> <engine a> <engine b> [--games N] [--workers N]
+//                   [--random-plies N] [--seed N]
+//
+#include <algorithm>
+#include <bit>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../classes/Connect4Search.h"
+#include "../classes/Connect4Solver.h"
+#include "../classes/OthelloSearch.h"
+#include "../classes/CheckersSearch.h"
+#include "../classes/MonteCarloSearch.h"
+#include "../classes/SearchPositions.h"
+
+struct EngineConfig
+{
+    std::string label;
+    std::string kind;
+    int         depth = 42;
+    int         timeMs = Connect4Search::SEARCH_TIME_MS;
+    int         threads = 1;
+    Connect4Search::EvalVersion eval = Connect4Search::EVAL_THREATS;
+    bool        dynamicOrdering = true;
+    int         endgameEmpties = OthelloSearch::ENDGAME_EMPTIES;
+    std::shared_ptr<OthelloPatterns> patterns;     // mapped once, shared by every game
+    std::shared_ptr<CheckersEndgame> endgame;
+};
+
+static bool parseEngine(const std::string &text, EngineConfig &config)
+{
+    config.label = text;
+    std::istringstream parts(text);
+    std::string part;
+    std::getline(parts, config.kind, ',');
+    while (std::getline(parts, part, ',')) {
+        size_t equals = part.find('=');
+        if (equals == std::string::npos) return false;
+        std::string key = part.substr(0, equals);
+        std::string value = part.substr(equals + 1);
+        if (key == "depth") config.depth = atoi(value.c_str());
+        else if (key == "time") config.timeMs = atoi(value.c_str());
+        else if (key == "threads") config.threads = atoi(value.c_str());
+        else if (key == "eval" && value == "legacy") config.eval = Connect4Search::EVAL_LEGACY;
+        else if (key == "eval" && value == "threats") config.eval = Connect4Search::EVAL_THREATS;
+        else if (key == "ordering") config.dynamicOrdering = (value != "static");
+        else if (key == "endgame") config.endgameEmpties = atoi(value.c_str());
+        else if (key == "weights") {
+            config.patterns = std::make_shared<OthelloPatterns>();
+            if (!config.patterns->open(value)) return false;
+        }
+        else if (key == "egdb") {
+            config.endgame = std::make_shared<CheckersEndgame>();
+            if (!config.endgame->open(value)) return false;
+        }
+        else return false;
+    }
+    return true;
+}
+
+// a smaller tree than the gui's, there are two of them for every worker
+static const size_t MCTS_MEGABYTES = 32;
+
+// one side of a game, owned by one worker thread so nothing is shared between games
+class Player
+{
+public:
+    // only the engine that's used gets built, each one allocates its own table
+    Player(const EngineConfig &config, const std::string &game) : _config(config)
+    {
+        if (config.kind == "mcts") {
+            if (game == "checkers") _checkersMonteCarlo = makeMonteCarlo<CheckersSearchPosition>(config);
+            else if (game == "othello") _othelloMonteCarlo = makeMonteCarlo<OthelloSearchPosition>(config);
+            else _connect4MonteCarlo = makeMonteCarlo<Connect4SearchPosition>(config);
+        } else if (game == "checkers") {
+            if (config.kind == "search") {
+                _checkersSearch = std::make_unique<CheckersSearch>();
+                _checkersSearch->setMaxDepth(config.depth);
+                _checkersSearch->setTimeBudget(config.timeMs);
+                _checkersSearch->setEndgame(config.endgame.get());
+            }
+        } else if (game == "othello") {
+            if (config.kind == "search") {
+                _othelloSearch = std::make_unique<OthelloSearch>();
+                _othelloSearch->setMaxDepth(config.depth);
+                _othelloSearch->setTimeBudget(config.timeMs);
+                _othelloSearch->setEndgameEmpties(config.endgameEmpties);
+                _othelloSearch->setPatterns(config.patterns.get());
+            }
+        } else if (config.kind == "search") {
+            _search = std::make_unique<Connect4Search>();
+            _search->setMaxDepth(config.depth);
+            _search->setTimeBudget(config.timeMs);
+            _search->setThreads(config.threads);
+            _search->setEvalVersion(config.eval);
+            _search->setDynamicOrdering(config.dynamicOrdering);
+        } else if (config.kind == "solver") {
+            _solver = std::make_unique<Connect4Solver>();
+            _solver->setTimeBudget(config.timeMs);
+        }
+    }
+
+    int connect4Move(const Connect4Position &position, std::mt19937 &rng)
+    {
+        if (_search) {
+            return _search->findBestMove(position);
+        }
+        if (_connect4MonteCarlo) {
+            int move = -1;
+            _connect4MonteCarlo->findBestMove(Connect4SearchPosition(position), move);
+            return move;
+        }
+        if (_solver) {
+            int score;
+            int move = _solver->bestMove(position.current(), position.opponent(), score);
+            if (move >= 0) return move;
+        }
+        std::vector<int> moves;
+        for (int col = 0; col < Connect4Position::WIDTH; col++) {
+            if (position.canPlay(col)) moves.push_back(col);
+        }
+        return moves[rng() % moves.size()];
+    }
+
+    int othelloMove(const OthelloPosition &position, std::mt19937 &rng)
+    {
+        if (_othelloSearch) {
+            return _othelloSearch->findBestMove(position);
+        }
+        if (_othelloMonteCarlo) {
+            OthelloSearchPosition::Move move = {-1, 0};
+            _othelloMonteCarlo->findBestMove(OthelloSearchPosition(position), move);
+            return move.square;
+        }
+        if (_config.kind == "greedy") {
+            return position.greedyMove();
+        }
+        return randomOthelloMove(position, rng);
+    }
+
+    // an index into position.generateMoves()
+    int checkersMove(const CheckersPosition &position, std::mt19937 &rng)
+    {
+        if (_checkersSearch) {
+            return _checkersSearch->findBestMove(position);
+        }
+        std::vector<CheckersPosition::Move> moves;
+        position.generateMoves(moves);
+        if (_checkersMonteCarlo) {
+            CheckersPosition::Move best;
+            _checkersMonteCarlo->findBestMove(CheckersSearchPosition(position), best);
+            for (size_t i = 0; i < moves.size(); i++) {
+                if (moves[i].from == best.from && moves[i].to == best.to && moves[i].captured == best.captured) {
+                    return (int)i;
+                }
+            }
+        }
+        return (int)(rng() % moves.size());
+    }
+
+    static int randomOthelloMove(const OthelloPosition &position, std::mt19937 &rng)
+    {
+        uint64_t moves = position.legalMoves();
+        if (!moves) return -1;
+        for (int skip = (int)(rng() % std::popcount(moves)); skip > 0; skip--) {
+            moves &= moves - 1;
+        }
+        return std::countr_zero(moves);
+    }
+
+private:
+    template <typename Position>
+    static std::unique_ptr<MonteCarloSearch<Position>> makeMonteCarlo(const EngineConfig &config)
+    {
+        auto search = std::make_unique<MonteCarloSearch<Position>>();
+        search->setTimeBudget(config.timeMs);
+        search->setThreads(config.threads);
+        search->setArenaSize(MCTS_MEGABYTES);
+        return search;
+    }
+
+    EngineConfig                    _config;
+    std::unique_ptr<Connect4Search> _search;
+    std::unique_ptr<Connect4Solver> _solver;
+    std::unique_ptr<OthelloSearch>  _othelloSearch;
+    std::unique_ptr<CheckersSearch> _checkersSearch;
+    std::unique_ptr<MonteCarloSearch<Connect4SearchPosition>> _connect4MonteCarlo;
+    std::unique_ptr<MonteCarloSearch<OthelloSearchPosition>>  _othelloMonteCarlo;
+    std::unique_ptr<MonteCarloSearch<CheckersSearchPosition>> _checkersMonteCarlo;
+};
+
+struct GameResult
+{
+    int     score;          // 1 if engine a won, 0 for a draw, -1 if it lost
+    double  seconds[2];     // thinking time of engine a and b
+    int     moves[2];
+};
+
+typedef std::chrono::steady_clock Clock;
+
+// players[0] is engine a, aIsFirst says whether it moves first (red / black)
+static GameResult playConnect4(Player *players[2], bool aIsFirst, int randomPlies, std::mt19937 &rng)
+{
+    GameResult result = {0, {0, 0}, {0, 0}};
+
+    // random opening, started over if it leaves the side to move a win in one
+    Connect4Position position;
+    for (bool ok = false; !ok;) {
+        position.reset();
+        for (int i = 0; i < randomPlies; i++) {
+            int col = (int)(rng() % Connect4Position::WIDTH);
+            if (position.canPlay(col)) {
+                position.play(col);
+            }
+        }
+        ok = true;
+        for (int col = 0; col < Connect4Position::WIDTH; col++) {
+            if (position.canPlay(col) && Connect4Search::isWin(position.current() | position.moveBit(col))) {
+                ok = false;
+            }
+        }
+    }
+
+    while (!position.isFull()) {
+        bool aToMove = (position.playerToMove() == Connect4Position::RED) == aIsFirst;
+        int side = aToMove ? 0 : 1;
+
+        auto start = Clock::now();
+        int col = players[side]->connect4Move(position, rng);
+        result.seconds[side] += std::chrono::duration<double>(Clock::now() - start).count();
+        result.moves[side]++;
+
+        position.play(col);
+        if (Connect4Search::isWin(position.opponent())) {
+            result.score = aToMove ? 1 : -1;
+            break;
+        }
+    }
+    return result;
+}
+
+static GameResult playOthello(Player *players[2], bool aIsFirst, int randomPlies, std::mt19937 &rng)
+{
+    GameResult result = {0, {0, 0}, {0, 0}};
+    OthelloPosition position;
+
+    // random opening
+    for (int i = 0; i < randomPlies && !position.mustPass(); i++) {
+        position.play(Player::randomOthelloMove(position, rng));
+    }
+
+    while (!position.isGameOver()) {
+        if (position.mustPass()) {
+            position.pass();
+            continue;
+        }
+
+        bool aToMove = (position.playerToMove() == OthelloPosition::BLACK) == aIsFirst;
+        int side = aToMove ? 0 : 1;
+
+        auto start = Clock::now();
+        int square = players[side]->othelloMove(position, rng);
+        result.seconds[side] += std::chrono::duration<double>(Clock::now() - start).count();
+        result.moves[side]++;
+
+        position.play(square);
+    }
+
+    int black = position.discCount(OthelloPosition::BLACK);
+    int white = position.discCount(OthelloPosition::WHITE);
+    int aDiscs = aIsFirst ? black : white;
+    int bDiscs = aIsFirst ? white : black;
+    result.score = (aDiscs > bDiscs) - (aDiscs < bDiscs);
+    return result;
+}
+
+static const int DRAW_PLIES = 80;
+
+static GameResult playCheckers(Player *players[2], bool aIsFirst, int randomPlies, std::mt19937 &rng)
+{
+    GameResult result = {0, {0, 0}, {0, 0}};
+    CheckersPosition position;
+    std::vector<CheckersPosition::Move> moves;
+
+    // random opening
+    for (int i = 0; i < randomPlies; i++) {
+        position.generateMoves(moves);
+        if (moves.empty()) break;
+        position.play(moves[rng() % moves.size()]);
+    }
+
+    int quietPlies = 0;
+    for (position.generateMoves(moves); !moves.empty(); position.generateMoves(moves)) {
+        if (quietPlies >= DRAW_PLIES) {
+            return result;
+        }
+
+        bool aToMove = (position.playerToMove() == CheckersPosition::RED) == aIsFirst;
+        int side = aToMove ? 0 : 1;
+
+        auto start = Clock::now();
+        int index = players[side]->checkersMove(position, rng);
+        result.seconds[side] += std::chrono::duration<double>(Clock::now() - start).count();
+        result.moves[side]++;
+
+        const CheckersPosition::Move &move = moves[index];
+        bool progress = move.jumps > 0 || !CheckersPosition::isKing(position.piece(move.from));
+        quietPlies = progress ? 0 : quietPlies + 1;
+        position.play(move);
+    }
+
+    // the side to move has nothing left and has lost
+    bool aLost = (position.playerToMove() == CheckersPosition::RED) == aIsFirst;
+    result.score = aLost ? -1 : 1;
+    return result;
+}
+
+// elo difference for an expected score, clamped so a clean sweep still prints a number
+static double eloFromScore(double score)
+{
+    score = std::clamp(score, 0.001, 0.999);
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 4) {
+        fprintf(stderr, "usage: tournament <connect4|othello|checkers> <engine a> <engine b> [--games N] [--workers N] "
+                        "[--random-plies N] [--seed N]\n");
+        return 1;
+    }
+
+    std::string game = argv[1];
+    EngineConfig configs[2];
+    if (!parseEngine(argv[2], configs[0]) || !parseEngine(argv[3], configs[1])) {
+        fprintf(stderr, "couldn't parse the engine settings\n");
+        return 1;
+    }
+    if (game != "connect4" && game != "othello" && game != "checkers") {
+        fprintf(stderr, "unknown game %s\n", game.c_str());
+        return 1;
+    }
+
+    int games = 100;
+    int workers = (int)std::thread::hardware_concurrency();
+    int randomPlies = (game == "connect4") ? 4 : 6;
+    unsigned seed = 1;
+    for (int i = 4; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--games") == 0) games = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--workers") == 0) workers = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--random-plies") == 0) randomPlies = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--seed") == 0) seed = (unsigned)atoi(argv[i + 1]);
+    }
+    games += games & 1;     // openings come in pairs
+    workers = std::max(1, workers);
+
+    std::vector<GameResult> results(games);
+    std::atomic<int> next(0);
+    std::mutex printLock;
+    auto start = Clock::now();
+
+    std::vector<std::thread> threads;
+    for (int w = 0; w < workers; w++) {
+        threads.emplace_back([&]() {
+            Player a(configs[0], game);
+            Player b(configs[1], game);
+            Player *players[2] = {&a, &b};
+            for (int i = next++; i < games; i = next++) {
+                // both games of a pair get the same opening, engine a moves first in the even one
+                std::mt19937 rng(seed * 1000003u + (unsigned)(i / 2));
+                bool aIsFirst = (i & 1) == 0;
+                if (game == "connect4") results[i] = playConnect4(players, aIsFirst, randomPlies, rng);
+                else if (game == "othello") results[i] = playOthello(players, aIsFirst, randomPlies, rng);
+                else results[i] = playCheckers(players, aIsFirst, randomPlies, rng);
+                std::lock_guard<std::mutex> lock(printLock);
+                fprintf(stderr, "\rgame %d / %d", i + 1, games);
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    fprintf(stderr, "\n");
+
+    int wins = 0, draws = 0, losses = 0;
+    double seconds[2] = {0, 0};
+    int moves[2] = {0, 0};
+    for (const GameResult &result : results) {
+        wins += result.score > 0;
+        draws += result.score == 0;
+        losses += result.score < 0;
+        for (int side = 0; side < 2; side++) {
+            seconds[side] += result.seconds[side];
+            moves[side] += result.moves[side];
+        }
+    }
+
+    // expected score with its standard error over the games played
+    double score = (wins + 0.5 * draws) / games;
+    double variance = (wins * std::pow(1.0 - score, 2) + draws * std::pow(0.5 - score, 2) +
+                       losses * std::pow(score, 2)) / games;
+    double error = std::sqrt(variance / games);
+
+    printf("%s: %s vs %s, %d games in %.1fs\n", game.c_str(), configs[0].label.c_str(), configs[1].label.c_str(),
+           games, std::chrono::duration<double>(Clock::now() - start).count());
+    printf("  +%d =%d -%d, score %.1f%%\n", wins, draws, losses, 100.0 * score);
+    printf("  elo %+.0f (95%% interval %+.0f to %+.0f)\n", eloFromScore(score),
+           eloFromScore(score - 1.96 * error), eloFromScore(score + 1.96 * error));
+    for (int side = 0; side < 2; side++) {
+        printf("  %s: %.3f ms per move\n", configs[side].label.c_str(),
+               moves[side] ? 1000.0 * seconds[side] / moves[side] : 0.0);
+    }
+    return 0;
+}